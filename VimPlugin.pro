@@ -2,11 +2,52 @@
 # libraries which breaks the tests in mac os x.
 TARGET = VimPlugin
 
-HEADERS += include/VimPlugin.h \
-           include/VimEngine.h
+QT += concurrent sql
 
-SOURCES += src/VimPlugin.cpp \
-           src/VimEngine.cpp
+HEADERS += include/VimPlugin.h        \
+           include/VimEngine.h        \
+           include/VimCommandLine.h   \
+           include/VimCompleter.h     \
+           include/VimConfig.h        \
+           include/VimConfigLoader.h  \
+           include/VimMacros.h        \
+           include/VimMarks.h         \
+           include/VimOutlinePicker.h \
+           include/VimPageHelper.h    \
+           include/VimPrefixIndex.h   \
+           include/VimRingBuffer.h    \
+           include/VimScrollMemory.h  \
+           include/VimScrollQuality.h \
+           include/VimSearchResults.h \
+           include/VimSelection.h     \
+           include/VimSessionRecorder.h \
+           include/VimTabDiscarder.h  \
+           include/VimTabPicker.h     \
+           include/VimTextIndex.h     \
+           include/VimThumbnailCache.h \
+           include/VimUrlMatcher.h
+
+SOURCES += src/VimPlugin.cpp          \
+           src/VimEngine.cpp          \
+           src/VimCommandLine.cpp     \
+           src/VimCompleter.cpp       \
+           src/VimConfig.cpp          \
+           src/VimConfigLoader.cpp    \
+           src/VimMacros.cpp          \
+           src/VimMarks.cpp           \
+           src/VimOutlinePicker.cpp   \
+           src/VimPageHelper.cpp      \
+           src/VimPrefixIndex.cpp     \
+           src/VimScrollMemory.cpp    \
+           src/VimScrollQuality.cpp   \
+           src/VimSearchResults.cpp   \
+           src/VimSelection.cpp       \
+           src/VimSessionRecorder.cpp \
+           src/VimTabDiscarder.cpp    \
+           src/VimTabPicker.cpp       \
+           src/VimTextIndex.cpp       \
+           src/VimThumbnailCache.cpp  \
+           src/VimUrlMatcher.cpp
 
 RESOURCES += vimplugin.qrc
 
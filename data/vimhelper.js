@@ -0,0 +1,722 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+/* Page side of the plugin. It runs in QupZilla's isolated JavaScript world,
+ * so pages can neither see nor break it, and keeps per page state that
+ * would be too expensive to rebuild on every key press.
+ */
+(function() {
+    'use strict';
+
+    if (window.__vimHelper)
+        return;
+
+    /* Scroll target: the element hjkl/d/u/G/gg act on. 'null' means it has
+     * to be looked up again, the document itself is a valid target.
+     */
+    var scrollTarget = null;
+
+    function scrollingElement(doc) {
+        return doc.scrollingElement || doc.documentElement;
+    }
+
+    function canScroll(el) {
+        if (!el || el.nodeType !== Node.ELEMENT_NODE)
+            return false;
+
+        var doc = el.ownerDocument;
+        if (el === scrollingElement(doc))
+            return el.scrollHeight > el.clientHeight
+                || el.scrollWidth > el.clientWidth;
+
+        var style = doc.defaultView.getComputedStyle(el);
+        var overflow_y = style.overflowY;
+        var overflow_x = style.overflowX;
+        return ((overflow_y === 'auto' || overflow_y === 'scroll')
+                    && el.scrollHeight > el.clientHeight)
+            || ((overflow_x === 'auto' || overflow_x === 'scroll')
+                    && el.scrollWidth > el.clientWidth);
+    }
+
+    function visibleArea(el) {
+        var rect = el.getBoundingClientRect();
+        return Math.max(0, rect.width) * Math.max(0, rect.height);
+    }
+
+    /* Scrollable ancestor of the focused element, following focus into
+     * same-origin frames.
+     */
+    function focusedScrollable() {
+        var doc = document;
+        var el = doc.activeElement;
+        while (el && el.contentDocument) {
+            try {
+                doc = el.contentDocument;
+            } catch (e) {
+                break;
+            }
+            el = doc.activeElement;
+        }
+
+        for (; el && el !== doc.body && el !== doc.documentElement;
+                el = el.parentElement) {
+            if (canScroll(el))
+                return el;
+        }
+
+        if (doc !== document && canScroll(scrollingElement(doc)))
+            return scrollingElement(doc);
+        return null;
+    }
+
+    /* Largest visible scrollable element, including the content of
+     * same-origin frames. Only used when the document itself does not
+     * scroll, which is the single page app case.
+     */
+    function largestScrollable(doc) {
+        var best = null;
+        var best_area = 0;
+
+        var walker = doc.createTreeWalker(doc.body || doc.documentElement,
+                NodeFilter.SHOW_ELEMENT);
+        for (var el = walker.currentNode; el; el = walker.nextNode()) {
+            var candidate = null;
+            if (el.tagName === 'IFRAME' || el.tagName === 'FRAME') {
+                try {
+                    var frame_doc = el.contentDocument;
+                    if (frame_doc) {
+                        candidate = canScroll(scrollingElement(frame_doc))
+                            ? scrollingElement(frame_doc)
+                            : largestScrollable(frame_doc);
+                    }
+                } catch (e) {
+                    /* Cross-origin frame. */
+                }
+            }
+            else if (canScroll(el)) {
+                candidate = el;
+            }
+
+            if (!candidate)
+                continue;
+            var area = visibleArea(candidate === scrollingElement(
+                        candidate.ownerDocument) ? el : candidate);
+            if (area > best_area) {
+                best = candidate;
+                best_area = area;
+            }
+        }
+
+        return best;
+    }
+
+    function findScrollTarget() {
+        var target = focusedScrollable();
+        if (target)
+            return target;
+
+        var root = scrollingElement(document);
+        if (!document.body || canScroll(root))
+            return root;
+
+        return largestScrollable(document) || root;
+    }
+
+    function target() {
+        if (!scrollTarget || !scrollTarget.isConnected)
+            scrollTarget = findScrollTarget();
+        return scrollTarget;
+    }
+
+    function invalidate() {
+        scrollTarget = null;
+    }
+
+    /* Most mutations do not matter: the target is only dropped when it
+     * leaves the document, or when the document is the fallback target and
+     * new content (an app shell rendering its scroller) shows up.
+     */
+    var observer = new MutationObserver(function(mutations) {
+        if (!scrollTarget)
+            return;
+        if (!scrollTarget.isConnected) {
+            invalidate();
+            return;
+        }
+        if (scrollTarget !== scrollingElement(document))
+            return;
+        for (var i = 0; i < mutations.length; ++i) {
+            if (mutations[i].addedNodes.length) {
+                invalidate();
+                return;
+            }
+        }
+    });
+    observer.observe(document, {childList: true, subtree: true});
+
+    document.addEventListener('focusin', invalidate, true);
+    window.addEventListener('resize', invalidate, true);
+
+    /* Link to the next or previous page of a paginated document: rel links
+     * first, then links whose text matches one of 'patterns', earlier
+     * patterns winning and, for the same pattern, the shortest text.
+     */
+    function pageLink(rel, patterns) {
+        var rels = 'prev' === rel ? ['prev', 'previous'] : [rel];
+        for (var i = 0; i < rels.length; ++i) {
+            var el = document.querySelector('link[rel~="' + rels[i]
+                    + '" i][href], a[rel~="' + rels[i] + '" i][href]');
+            if (el)
+                return el.href;
+        }
+
+        var candidates = [];
+        var links = document.querySelectorAll('a[href], area[href]');
+        for (var link_i = 0; link_i < links.length; ++link_i) {
+            var link = links[link_i];
+            if (!link.getClientRects().length || /^javascript:/i.test(link.href))
+                continue;
+            var text = (link.innerText || link.getAttribute('aria-label')
+                    || link.title || '').trim().toLowerCase();
+            if (text && text.length <= 40)
+                candidates.push({text: text, href: link.href});
+        }
+
+        for (var pattern_i = 0; pattern_i < patterns.length; ++pattern_i) {
+            var escaped = patterns[pattern_i].toLowerCase()
+                .replace(/[.*+?^${}()|[\]\\]/g, '\\$&');
+            var regex = new RegExp('(^|\\W)' + escaped + '(\\W|$)');
+            var best = null;
+            for (var c = 0; c < candidates.length; ++c) {
+                if (regex.test(candidates[c].text)
+                        && (!best || candidates[c].text.length < best.text.length))
+                    best = candidates[c];
+            }
+            if (best)
+                return best.href;
+        }
+
+        return '';
+    }
+
+    /* Following the bottom after 'G'. A ResizeObserver notes when the
+     * content grows and chases the new bottom right here, one step per
+     * frame, so growth costs the plugin no call at all: it only asks once
+     * in a while whether following is still worth it, see 'followState'.
+     */
+    var follow = null;
+
+    function followedContent(el) {
+        return el === scrollingElement(el.ownerDocument)
+            ? (el.ownerDocument.body || el) : (el.firstElementChild || el);
+    }
+
+    /* New content is covered in about 'steps' frames however much of it
+     * arrived, never slower than 'step' pixels a frame.
+     */
+    function startFollowing(step, steps) {
+        stopFollowing();
+        var el = target();
+        follow = {
+            element: el,
+            height: el.scrollHeight,
+            grown_at: performance.now(),
+            top: el.scrollTop,
+            min_step: step,
+            steps: steps,
+            step: step,
+            frame: 0,
+            observer: new ResizeObserver(function() {
+                if (!follow || follow.element.scrollHeight <= follow.height)
+                    return;
+                follow.height = follow.element.scrollHeight;
+                follow.grown_at = performance.now();
+                follow.step = Math.max(follow.min_step,
+                    Math.ceil(distanceToEnd(follow.element) / follow.steps));
+                if (!follow.frame)
+                    follow.frame = requestAnimationFrame(chaseBottom);
+            })
+        };
+        follow.observer.observe(followedContent(el));
+    }
+
+    function stopFollowing() {
+        if (!follow)
+            return;
+        follow.observer.disconnect();
+        cancelAnimationFrame(follow.frame);
+        follow = null;
+    }
+
+    function distanceToEnd(el) {
+        return Math.max(0, el.scrollHeight - el.clientHeight - el.scrollTop);
+    }
+
+    /* Gives up once the user scrolled up on their own. */
+    function chaseBottom() {
+        follow.frame = 0;
+        var el = follow.element;
+        if (!el.isConnected || el.scrollTop < follow.top - 1) {
+            stopFollowing();
+            return;
+        }
+
+        var remaining = distanceToEnd(el);
+        if (remaining > 0) {
+            scrollTo(el, el.scrollLeft,
+                el.scrollTop + Math.min(follow.step, remaining));
+            follow.frame = requestAnimationFrame(chaseBottom);
+        }
+        follow.top = el.scrollTop;
+    }
+
+    /* What is left to scroll and how long ago the content last grew, or
+     * null once following stopped on its own.
+     */
+    function followState() {
+        if (!follow)
+            return null;
+        if (!follow.element.isConnected
+                || follow.element.scrollTop < follow.top - 1) {
+            stopFollowing();
+            return null;
+        }
+        return [distanceToEnd(follow.element),
+                Math.round(performance.now() - follow.grown_at)];
+    }
+
+    /* Caret and visual mode. The caret is shown as a one character
+     * selection starting at it, like Vimium does, since pages that are not
+     * editable draw no caret.
+     */
+    var selectionMotions = {
+        'h': ['backward', 'character'],
+        'l': ['forward', 'character'],
+        'j': ['forward', 'line'],
+        'k': ['backward', 'line'],
+        'w': ['forward', 'word'],
+        'b': ['backward', 'word'],
+        '$': ['forward', 'lineboundary'],
+        '^': ['backward', 'lineboundary']
+    };
+
+    function inViewport(rect) {
+        return rect.bottom > 0 && rect.top < window.innerHeight
+            && (rect.width > 0 || rect.height > 0);
+    }
+
+    function focusRect(sel) {
+        var range = document.createRange();
+        range.setStart(sel.focusNode, sel.focusOffset);
+        var rects = range.getClientRects();
+        if (rects.length)
+            return rects[0];
+        var el = sel.focusNode.nodeType === Node.ELEMENT_NODE
+            ? sel.focusNode : sel.focusNode.parentElement;
+        return el ? el.getBoundingClientRect() : null;
+    }
+
+    /* First text on screen, where a new caret starts. */
+    function firstVisibleText() {
+        if (!document.body)
+            return null;
+        var walker = document.createTreeWalker(document.body,
+                NodeFilter.SHOW_TEXT);
+        var range = document.createRange();
+        for (var node = walker.nextNode(); node; node = walker.nextNode()) {
+            if (!/\S/.test(node.data))
+                continue;
+            range.selectNodeContents(node);
+            var rect = range.getBoundingClientRect();
+            if (inViewport(rect) && rect.top >= 0)
+                return node;
+        }
+        return null;
+    }
+
+    function showCaret(sel) {
+        sel.collapseToStart();
+        sel.modify('extend', 'forward', 'character');
+    }
+
+    function revealSelection(sel) {
+        var rect = focusRect(sel);
+        if (!rect)
+            return;
+        var margin = 20;
+        var dy = 0;
+        if (rect.top < 0)
+            dy = rect.top - margin;
+        else if (rect.bottom > window.innerHeight)
+            dy = rect.bottom - window.innerHeight + margin;
+        if (dy)
+            scrollBy(0, dy);
+    }
+
+    function enterSelection(mode) {
+        var sel = window.getSelection();
+        var rect = sel.rangeCount ? focusRect(sel) : null;
+        if (!rect || !inViewport(rect)) {
+            var node = firstVisibleText();
+            if (!node)
+                return false;
+            sel.collapse(node, node.data.search(/\S/));
+        }
+        if ('caret' === mode || sel.isCollapsed)
+            showCaret(sel);
+        return true;
+    }
+
+    /* 'motions' is a run-length string like "12l3w", with the '0' motion
+     * spelled '^' so that it never reads as a count.
+     */
+    function moveSelection(mode, motions) {
+        var sel = window.getSelection();
+        if (!sel.rangeCount)
+            return;
+
+        var caret = 'caret' === mode;
+        if (caret)
+            sel.collapseToStart();
+
+        var re = /(\d*)(\D)/g;
+        var match;
+        while ((match = re.exec(motions))) {
+            var motion = selectionMotions[match[2]];
+            if (!motion)
+                continue;
+            var count = match[1] ? parseInt(match[1], 10) : 1;
+            for (var i = 0; i < count; ++i)
+                sel.modify(caret ? 'move' : 'extend', motion[0], motion[1]);
+        }
+
+        if (caret)
+            sel.modify('extend', 'forward', 'character');
+        revealSelection(sel);
+    }
+
+    /* Headings, landmarks and paragraphs for ']h', '[h', ']p' and 'gO',
+     * each kind a list in document order. The lists are built on the
+     * first structural motion and then kept current from mutations, so a
+     * jump is a binary search and one scroll instead of a query over the
+     * whole document per key press.
+     */
+    var outlineSelectors = {
+        heading: 'h1, h2, h3, h4, h5, h6, [role="heading"]',
+        landmark: 'main, nav, aside, body > header, body > footer, '
+            + '[role="main"], [role="navigation"], [role="banner"], '
+            + '[role="contentinfo"], [role="complementary"], '
+            + '[role="search"], [role="region"][aria-label], '
+            + '[role="region"][aria-labelledby]',
+        paragraph: 'p'
+    };
+    var outline = null;
+    /* Elements of the last 'gO' listing, which the picker refers to by
+     * index.
+     */
+    var outlineListing = [];
+    /* Added elements matching more than this are cheaper to sort by
+     * rebuilding the list than by inserting them one by one.
+     */
+    var outlineMaxInserts = 256;
+
+    function outlineInsert(list, el) {
+        var low = 0;
+        var high = list.length;
+        while (low < high) {
+            var mid = (low + high) >> 1;
+            if (list[mid].compareDocumentPosition(el)
+                    & Node.DOCUMENT_POSITION_FOLLOWING)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (list[low] !== el)
+            list.splice(low, 0, el);
+    }
+
+    function outlineMatches(node, selector) {
+        var matches = Array.prototype.slice.call(
+                node.querySelectorAll(selector));
+        if (node.matches(selector))
+            matches.unshift(node);
+        return matches;
+    }
+
+    function outlineChanged(mutations) {
+        var removed = false;
+        var added = [];
+        for (var i = 0; i < mutations.length; ++i) {
+            removed = removed || mutations[i].removedNodes.length > 0;
+            var nodes = mutations[i].addedNodes;
+            for (var node_i = 0; node_i < nodes.length; ++node_i) {
+                if (nodes[node_i].nodeType === Node.ELEMENT_NODE)
+                    added.push(nodes[node_i]);
+            }
+        }
+
+        for (var kind in outlineSelectors) {
+            var list = outline[kind];
+            /* Removed entries go first, positions are only defined for
+             * connected nodes.
+             */
+            if (removed) {
+                list = outline[kind] = list.filter(function(el) {
+                    return el.isConnected;
+                });
+            }
+
+            var matches = [];
+            for (var added_i = 0; added_i < added.length; ++added_i) {
+                if (added[added_i].isConnected)
+                    matches = matches.concat(outlineMatches(added[added_i],
+                                outlineSelectors[kind]));
+            }
+            if (matches.length > outlineMaxInserts) {
+                outline[kind] = Array.prototype.slice.call(
+                        document.querySelectorAll(outlineSelectors[kind]));
+                continue;
+            }
+            for (var match_i = 0; match_i < matches.length; ++match_i)
+                outlineInsert(list, matches[match_i]);
+        }
+    }
+
+    function outlineList(kind) {
+        if (!outline) {
+            outline = {};
+            for (var name in outlineSelectors) {
+                outline[name] = Array.prototype.slice.call(
+                        document.querySelectorAll(outlineSelectors[name]));
+            }
+            new MutationObserver(outlineChanged).observe(document,
+                    {childList: true, subtree: true});
+        }
+        return outline[kind] || [];
+    }
+
+    function isShown(el) {
+        return el.getClientRects().length > 0;
+    }
+
+    /* Index of the first entry whose top is below 'y' in the viewport.
+     * Document order is taken as vertical order.
+     */
+    function firstBelow(list, y) {
+        var low = 0;
+        var high = list.length;
+        while (low < high) {
+            var mid = (low + high) >> 1;
+            if (list[mid].getBoundingClientRect().top <= y)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    /* Moves 'count' entries of 'kind' down, or up if negative, from the
+     * top of the viewport. Returns false if there is none that way.
+     */
+    function jumpToOutline(kind, count) {
+        var list = outlineList(kind);
+        var step = count < 0 ? -1 : 1;
+        var i = count < 0 ? firstBelow(list, -1) - 1 : firstBelow(list, 1);
+        var found = null;
+        for (var left = Math.abs(count); left > 0 && i >= 0 && i < list.length;
+                i += step) {
+            if (isShown(list[i])) {
+                found = list[i];
+                --left;
+            }
+        }
+        if (!found)
+            return false;
+        found.scrollIntoView({block: 'start', behavior: 'instant'});
+        return true;
+    }
+
+    var landmarkRoles = {
+        MAIN: 'main',
+        NAV: 'navigation',
+        ASIDE: 'complementary',
+        HEADER: 'banner',
+        FOOTER: 'contentinfo'
+    };
+
+    function landmarkName(el) {
+        var role = el.getAttribute('role') || landmarkRoles[el.tagName];
+        var label = el.getAttribute('aria-label');
+        var labelled_by = el.getAttribute('aria-labelledby');
+        if (!label && labelled_by) {
+            var label_el = document.getElementById(labelled_by.split(' ')[0]);
+            label = label_el ? label_el.innerText : '';
+        }
+        return label ? role + ': ' + label.trim() : role;
+    }
+
+    function headingLevel(el) {
+        var match = /^H([1-6])$/.exec(el.tagName);
+        if (match)
+            return parseInt(match[1], 10);
+        return parseInt(el.getAttribute('aria-level'), 10) || 2;
+    }
+
+    /* Shown headings and landmarks in document order, each as
+     * [level, text] with level 0 for landmarks.
+     */
+    function outlineEntries(max_text) {
+        var headings = outlineList('heading');
+        var landmarks = outlineList('landmark');
+        var res = [];
+        var heading_i = 0;
+        var landmark_i = 0;
+        outlineListing = [];
+        while (heading_i < headings.length || landmark_i < landmarks.length) {
+            var is_landmark = heading_i >= headings.length
+                || (landmark_i < landmarks.length
+                    && (headings[heading_i].compareDocumentPosition(
+                            landmarks[landmark_i])
+                        & Node.DOCUMENT_POSITION_PRECEDING));
+            var el = is_landmark ? landmarks[landmark_i++]
+                                 : headings[heading_i++];
+            if (!isShown(el))
+                continue;
+            var text = is_landmark ? landmarkName(el)
+                                   : el.innerText.replace(/\s+/g, ' ').trim();
+            if (!text)
+                continue;
+            outlineListing.push(el);
+            res.push([is_landmark ? 0 : headingLevel(el),
+                    text.slice(0, max_text)]);
+        }
+        return res;
+    }
+
+    function jumpToListing(index) {
+        var el = outlineListing[index];
+        if (!el || !el.isConnected)
+            return false;
+        el.scrollIntoView({block: 'start', behavior: 'instant'});
+        return true;
+    }
+
+    /* The plugin animates on its own, a page asking for smooth scrolling
+     * must not stretch each step.
+     */
+    function scrollBy(dx, dy) {
+        var el = target();
+        var options = {left: dx, top: dy, behavior: 'instant'};
+        if (el === scrollingElement(el.ownerDocument))
+            el.ownerDocument.defaultView.scrollBy(options);
+        else
+            el.scrollBy(options);
+    }
+
+    function scrollTo(el, left, top) {
+        var options = {left: left, top: top, behavior: 'instant'};
+        if (el === scrollingElement(el.ownerDocument))
+            el.ownerDocument.defaultView.scrollTo(options);
+        else
+            el.scrollTo(options);
+    }
+
+    window.__vimHelper = {
+        pageLink: pageLink,
+        /* What ':tabsearch' searches, read once per load. */
+        visibleText: function(max_length) {
+            return document.body
+                ? document.body.innerText.slice(0, max_length) : '';
+        },
+
+        startFollowing: startFollowing,
+        stopFollowing: stopFollowing,
+        followState: followState,
+        jumpToOutline: jumpToOutline,
+        outline: outlineEntries,
+        jumpToListing: jumpToListing,
+        enterSelection: enterSelection,
+        moveSelection: moveSelection,
+
+        yankSelection: function() {
+            var sel = window.getSelection();
+            var text = sel.toString();
+            sel.removeAllRanges();
+            return text;
+        },
+
+        leaveSelection: function() {
+            window.getSelection().removeAllRanges();
+        },
+
+        /* Lets the browser fetch the page ']]' would open while the user is
+         * still reading this one.
+         */
+        prefetchPageLink: function(rel, patterns) {
+            var url = pageLink(rel, patterns);
+            if (!url || url === location.href
+                    || document.querySelector('link[data-vimplugin-prefetch]'))
+                return url;
+
+            var hint = document.createElement('link');
+            hint.rel = 'prefetch';
+            hint.href = url;
+            hint.setAttribute('data-vimplugin-prefetch', '');
+            (document.head || document.documentElement).appendChild(hint);
+            return url;
+        },
+
+        scrollBy: scrollBy,
+
+        /* 'edge' < 0 is the top, > 0 the bottom. */
+        scrollToEdge: function(edge) {
+            var el = target();
+            scrollTo(el, el.scrollLeft, edge < 0 ? 0 : el.scrollHeight);
+        },
+
+        /* Position as a fraction of the scroll range on each axis, what
+         * pages bound with ':scrollbind' follow.
+         */
+        scrollRatio: function() {
+            var el = target();
+            var range_x = el.scrollWidth - el.clientWidth;
+            var range_y = el.scrollHeight - el.clientHeight;
+            return [range_x > 0 ? el.scrollLeft / range_x : 0,
+                    range_y > 0 ? el.scrollTop / range_y : 0];
+        },
+
+        /* A negative ratio leaves that axis alone. */
+        scrollToRatio: function(ratio_x, ratio_y) {
+            var el = target();
+            scrollTo(el,
+                ratio_x < 0 ? el.scrollLeft
+                    : Math.round(ratio_x * (el.scrollWidth - el.clientWidth)),
+                ratio_y < 0 ? el.scrollTop
+                    : Math.round(ratio_y * (el.scrollHeight - el.clientHeight)));
+        },
+
+        scrollTop: function() {
+            return target().scrollTop;
+        },
+
+        distanceToBottom: function() {
+            var el = target();
+            return el.scrollHeight - el.clientHeight - el.scrollTop;
+        }
+    };
+})();
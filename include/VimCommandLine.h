@@ -0,0 +1,86 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_COMMAND_LINE_H
+#define VIM_COMMAND_LINE_H
+
+#include "VimCompleter.h"
+
+#include <QHash>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTimer>
+#include <QWidget>
+
+/* The ':' line shown at the bottom of the web view. It only edits text and
+ * cycles completions; running the commands is up to the engine.
+ */
+class VimCommandLine : public QWidget
+{
+    Q_OBJECT
+
+    public:
+        explicit VimCommandLine(VimCompleter *completer, QWidget *parent);
+
+        void setArgumentSources(const QString &command,
+                const QList<VimCompleter::Source> &sources);
+
+        void open();
+        void showMessage(const QString &message);
+
+        QString text() const
+        {
+            return m_edit.text();
+        }
+
+    signals:
+        void commandEntered(const QString &command);
+
+    protected:
+        bool eventFilter(QObject *obj, QEvent *event);
+
+    private slots:
+        void leave();
+        void resetCompletion();
+        void completerRefreshed();
+
+    private:
+        void complete(bool backwards);
+        void showWildMenu();
+        void browseHistory(int direction);
+        void placeAtBottom();
+
+        static const int m_max_completions;
+        static const int m_max_history;
+        static const int m_message_timeout;
+        VimCompleter *m_completer;
+        QHash<QString, QList<VimCompleter::Source> > m_argument_sources;
+        QLabel m_wild_menu;
+        QLabel m_prompt;
+        QLineEdit m_edit;
+        QTimer m_message_timer;
+        QString m_completion_base;
+        QStringList m_completions;
+        int m_completion_i;
+        /* A Tab found nothing while history was still loading. */
+        bool m_completion_waiting;
+        QStringList m_history;
+        int m_history_i;
+};
+
+#endif
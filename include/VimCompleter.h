@@ -0,0 +1,120 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_COMPLETER_H
+#define VIM_COMPLETER_H
+
+#include "VimPrefixIndex.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+
+class TabWidget;
+struct HistoryEntry;
+
+/* Owns the completion indexes used by the command line. Indexes are built
+ * in a worker thread and swapped in when ready; lookups always run against
+ * the last finished build and never wait for a running one.
+ *
+ * History is only queried once something asks to complete it. Pages
+ * visited afterwards go to a small index of their own, so browsing does
+ * not make the next completion query the whole history again.
+ */
+class VimCompleter : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Source {
+            Commands,
+            Tabs,
+            Bookmarks,
+            History
+        };
+
+        explicit VimCompleter(QObject *parent = nullptr);
+
+        void setCommands(const QStringList &commands);
+        void refresh(TabWidget *tab_widget);
+        /* Loads the history index, if it is not loaded already. */
+        void requestHistory();
+
+        QVector<VimPrefixIndex::Item> complete(Source source,
+                const QString &prefix, int limit) const;
+
+        bool isRefreshing() const
+        {
+            return m_watcher.isRunning();
+        }
+
+        bool isHistoryLoaded() const
+        {
+            return m_history_wanted && !m_history_dirty && m_indexes
+                && !m_watcher.isRunning();
+        }
+
+    signals:
+        void refreshed();
+
+    private slots:
+        void indexesBuilt();
+        void invalidateBookmarks();
+        void invalidateHistory();
+        void addHistoryEntry(const HistoryEntry &entry);
+
+    private:
+        struct PageEntry {
+            QString title;
+            QString url;
+        };
+
+        struct Indexes {
+            VimPrefixIndex tabs;
+            VimPrefixIndex bookmarks;
+            VimPrefixIndex history;
+            /* Visited since 'history' was queried, most recent first. */
+            VimPrefixIndex recent_history;
+        };
+
+        typedef QSharedPointer<const Indexes> IndexesPtr;
+
+        static IndexesPtr buildIndexes(const QVector<PageEntry> &tabs,
+                const QVector<PageEntry> &bookmarks, bool build_history,
+                const QVector<PageEntry> &recent_history,
+                IndexesPtr previous);
+
+        void connectSources();
+
+        static const int m_max_history_entries;
+        static const int m_max_recent_history;
+        VimPrefixIndex m_commands;
+        IndexesPtr m_indexes;
+        QFutureWatcher<IndexesPtr> m_watcher;
+        bool m_sources_connected;
+        bool m_bookmarks_dirty;
+        bool m_history_dirty;
+        bool m_history_wanted;
+        QVector<PageEntry> m_recent_history;
+        bool m_refresh_pending;
+        QPointer<TabWidget> m_pending_tab_widget;
+        QPointer<TabWidget> m_tab_widget;
+};
+
+#endif
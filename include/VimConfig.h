@@ -0,0 +1,174 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_CONFIG_H
+#define VIM_CONFIG_H
+
+#include "VimUrlMatcher.h"
+
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+class QKeyEvent;
+class VimConfig;
+
+typedef QSharedPointer<const VimConfig> VimConfigPtr;
+
+/* Compiled keymap and options.
+ *
+ * A config is built once from vimrc-like source text and never changes
+ * afterwards: a new source (or a ':set') compiles a new config which
+ * replaces the old one as a whole. The key handling path only does hash
+ * lookups on it.
+ *
+ * Source syntax, one statement per line:
+ *
+ *   " comment
+ *   set {option}={value}
+ *   map {keys} {action}
+ *   map {keys} :{command}
+ *   unmap {keys}
+ *   mapclear
+ *   exclude {url pattern} [pass keys]
+ */
+class VimConfig
+{
+    public:
+        enum ActionType {
+            NoAction,
+            ScrollLeft,
+            ScrollDown,
+            ScrollUp,
+            ScrollRight,
+            ScrollHalfPageDown,
+            ScrollHalfPageUp,
+            ScrollToTop,
+            ScrollToBottom,
+            Reload,
+            NextTab,
+            PreviousTab,
+            RemoveTab,
+            RestoreTab,
+            EnterCommandLine,
+            RunCommand,
+            SetMark,
+            JumpToMark,
+            JumpOlder,
+            JumpNewer,
+            NextPage,
+            PreviousPage,
+            RecordMacro,
+            ReplayMacro,
+            TabPicker,
+            CaretMode,
+            VisualMode,
+            ZoomIn,
+            ZoomOut,
+            ZoomReset,
+            NextHeading,
+            PreviousHeading,
+            NextLandmark,
+            PreviousLandmark,
+            NextParagraph,
+            PreviousParagraph,
+            Outline
+        };
+
+        struct Action {
+            ActionType type;
+            QString command;
+        };
+
+        static VimConfigPtr defaults();
+        static VimConfigPtr compile(const QString &source,
+                QStringList *errors);
+
+        VimConfigPtr withOption(const QString &name, const QString &value,
+                QString *error) const;
+
+        Action action(const QString &keys) const
+        {
+            return m_keymap.value(keys, Action{NoAction, QString()});
+        }
+
+        bool isPrefix(const QString &keys) const
+        {
+            return m_prefixes.contains(keys);
+        }
+
+        QVariant option(const QString &name) const
+        {
+            return m_options.value(name);
+        }
+
+        VimUrlMatcher::Verdict exclusion(const QUrl &url) const
+        {
+            return m_exclusions->match(url);
+        }
+
+        int exclusionRuleCount() const
+        {
+            return m_exclusions->ruleCount();
+        }
+
+        int singleStep() const
+        {
+            return m_single_step;
+        }
+
+        int singleStepInterval() const
+        {
+            return m_single_step_interval;
+        }
+
+        int numScrollSteps() const
+        {
+            return m_num_scroll_steps;
+        }
+
+        static bool takesArgument(ActionType type);
+        static QString keyName(const QKeyEvent *event);
+        static QStringList optionNames();
+
+    private:
+        VimConfig();
+
+        void apply(const QString &source, QStringList *errors);
+        bool setOption(const QString &name, const QString &value,
+                QString *error);
+        void finalize();
+        static QStringList splitKeys(const QString &keys);
+
+        static const char *const m_default_source;
+        QHash<QString, Action> m_keymap;
+        QSet<QString> m_prefixes;
+        QHash<QString, QVariant> m_options;
+        /* Only modified while compiling, copies made by 'withOption' share
+         * it read-only.
+         */
+        QSharedPointer<VimUrlMatcher> m_exclusions;
+        int m_single_step;
+        int m_single_step_interval;
+        int m_num_scroll_steps;
+};
+
+#endif
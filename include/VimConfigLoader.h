@@ -0,0 +1,95 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_CONFIG_LOADER_H
+#define VIM_CONFIG_LOADER_H
+
+#include "VimConfig.h"
+
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QTimer>
+
+/* Watches the user config file and compiles it in a worker thread whenever
+ * it changes. The compiled config is handed over on the UI thread through
+ * 'configChanged', the file is never read or parsed there.
+ */
+class VimConfigLoader : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit VimConfigLoader(QObject *parent = nullptr);
+
+        void setFilePath(const QString &file_path);
+
+        QString filePath() const
+        {
+            return m_file_path;
+        }
+
+        VimConfigPtr config() const
+        {
+            return m_config;
+        }
+
+        /* False until the first compile is handed over, 'config' holds the
+         * defaults meanwhile.
+         */
+        bool isLoaded() const
+        {
+            return m_loaded;
+        }
+
+        QStringList errors() const
+        {
+            return m_errors;
+        }
+
+    signals:
+        void configChanged();
+
+    public slots:
+        void reload();
+
+    private slots:
+        void watchedPathChanged();
+        void compiled();
+
+    private:
+        struct Result {
+            VimConfigPtr config;
+            QStringList errors;
+        };
+
+        static Result load(const QString &file_path);
+        void updateWatchedPaths();
+
+        static const int m_reload_delay;
+        QString m_file_path;
+        QFileSystemWatcher m_fs_watcher;
+        QTimer m_reload_timer;
+        QFutureWatcher<Result> m_compile_watcher;
+        VimConfigPtr m_config;
+        QStringList m_errors;
+        bool m_reload_pending;
+        bool m_loaded;
+};
+
+#endif
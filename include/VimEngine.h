@@ -20,10 +20,33 @@
 #define VIM_ENGINE_H
 
 #include "webpage.h"
+#include "VimCompleter.h"
+#include "VimConfig.h"
+#include "VimConfigLoader.h"
+#include "VimMacros.h"
+#include "VimMarks.h"
+#include "VimScrollMemory.h"
+#include "VimScrollQuality.h"
+#include "VimSelection.h"
+#include "VimSessionRecorder.h"
+#include "VimTabDiscarder.h"
+#include "VimTextIndex.h"
+#include "VimThumbnailCache.h"
 
+#include <QElapsedTimer>
 #include <QKeyEvent>
+#include <QPointer>
+#include <QSet>
 #include <QTimer>
 
+class TabWidget;
+class VimCommandLine;
+class VimOutlinePicker;
+class VimSearchResults;
+class WebView;
+class QWindow;
+class VimTabPicker;
+
 class VimEngine : public QObject
 {
     Q_OBJECT
@@ -33,65 +56,329 @@ class VimEngine : public QObject
 
         void handleKeyPressEvent(WebPage *page, QKeyEvent *event);
         void handleKeyReleaseEvent(WebPage *page, QKeyEvent *event);
+        void setSettingsPath(const QString &settings_path);
+        bool isExcluded(WebPage *page);
+        void handleNavigationRequest(WebPage *page, const QUrl &url,
+                QWebEnginePage::NavigationType type, bool is_main_frame);
 
 #ifdef VIM_PLUGIN_TESTS
         void init()
         {
+            start();
             stopScroll();
-            m_g_pressed = false;
+            m_pending_keys.clear();
+            m_pending_argument = VimConfig::NoAction;
+            m_config = m_config_loader.config();
+            applyConfig();
+            m_marks.clear();
+            m_paging_pages.clear();
+            m_macros.clear();
+            m_count = 0;
+            m_last_macro_register = QChar();
+            m_batch = Batch();
+            m_selection.forgetPage(m_selection.page());
+            m_zoom_timer.stop();
+            m_zoom_page = nullptr;
+            m_zoom_steps = 0;
+            m_zoom_reset = false;
+            stopFollowingBottom();
+            m_scroll_bound.clear();
+            m_scroll_quality.clear();
             m_page = nullptr;
         }
 
+        const VimCommandLine* commandLine() const
+        {
+            return m_command_line;
+        }
+
+        const VimCompleter* completer() const
+        {
+            return &m_completer;
+        }
+
+        const VimTabDiscarder* tabDiscarder() const
+        {
+            return &m_tab_discarder;
+        }
+
+        const VimScrollMemory* scrollMemory() const
+        {
+            return &m_scroll_memory;
+        }
+
+        const VimMarks* marks() const
+        {
+            return &m_marks;
+        }
+
         const QTimer* scrollTimer() const
         {
             return &m_scroll_timer;
         }
 
+        const QTimer* zoomTimer() const
+        {
+            return &m_zoom_timer;
+        }
+
+        bool isFollowingBottom() const
+        {
+            return m_follow_page;
+        }
+
+        VimScrollQuality scrollQuality(WebPage *page) const
+        {
+            return m_scroll_quality.value(page);
+        }
+
+        int scrollBoundCount() const
+        {
+            return m_scroll_bound.size();
+        }
+
         static int stepSize()
         {
-            return m_single_step;
+            return VimConfig::defaults()->singleStep();
         }
 
         static int scrollSizeWithHJKL()
         {
-            return m_single_step * m_num_scroll_steps;
+            return stepSize() * numSteps();
         }
 
         static int stepsInterval()
         {
-            return m_single_step_interval;
+            return VimConfig::defaults()->singleStepInterval();
         }
 
         static int numSteps()
         {
-            return m_num_scroll_steps;
+            return VimConfig::defaults()->numScrollSteps();
+        }
+
+        const VimConfigLoader* configLoader() const
+        {
+            return &m_config_loader;
+        }
+
+        VimConfigPtr config() const
+        {
+            return m_config;
+        }
+
+        const VimMacros* macros() const
+        {
+            return &m_macros;
+        }
+
+        const VimThumbnailCache* thumbnails() const
+        {
+            return &m_thumbnails;
+        }
+
+        const VimSelection* selection() const
+        {
+            return &m_selection;
+        }
+
+        const VimTabPicker* tabPicker() const
+        {
+            return m_tab_picker;
+        }
+
+        const VimTextIndex* textIndex() const
+        {
+            return &m_text_index;
+        }
+
+        const VimSearchResults* searchResults() const
+        {
+            return m_search_results;
+        }
+
+        const VimOutlinePicker* outlinePicker() const
+        {
+            return m_outline_picker;
         }
 #endif
 
     public slots:
         void stopScrollingIfPageWasDeleted(WebPage *deleted_page);
+        bool executeCommand(const QString &command_line);
+        void forgetPage(WebPage *deleted_page);
+        void runCommandLine(const QString &command_line);
 
     private slots:
         void scroll();
+        void reportDiscarded(int count, qint64 reclaimed_kb);
+        void reportYanked(int length);
+        void configChanged();
+        void pageUrlChanged();
+        void prefetchPageLink(bool ok);
+        void pickTab(int index);
+        void applyZoom();
+        void followBottom();
+        void stopAnimations();
+        void applicationStateChanged(Qt::ApplicationState state);
+        void focusWindowChanged(QWindow *window);
+        void reportSearch(const QString &text, int matches);
+        void jumpToMatch(WebTab *tab);
+        void findPendingText();
+        void pageScrolled();
+        void jumpToOutlineEntry(int index);
 
     private:
+        /* Effects of a macro replay not applied yet. Scrolls and tab
+         * switches add up and are applied at once, without animation, when
+         * the replay ends or an action that depends on them runs.
+         */
+        struct Batch {
+            Batch()
+                : active(false)
+                , scroll_hor(0)
+                , scroll_vert(0)
+                , scroll_edge(0)
+                , tab_offset(0)
+            {
+            }
+
+            bool active;
+            int scroll_hor;
+            int scroll_vert;
+            /* -1 for the top, 1 for the bottom. */
+            int scroll_edge;
+            int tab_offset;
+        };
+
+        /* A page the user paged through with ']]' or '[['. */
+        struct Paging {
+            QString rel;
+            /* Where the last ']]' or '[[' went, until it loaded. */
+            QUrl target;
+        };
+
+        void start();
         void startScroll(int scroll_hor, int scroll_vert);
         void startFullVerticalScroll(int scroll_step_size);
         void stopScroll();
+        void startScrollTimer();
+        void toggleScrollBind();
+        void syncBoundPages(bool hor, bool vert);
         void nextTab();
         void previousTab();
         void closeCurTab();
         void openLastClosedTab();
+        void openCommandLine();
+        bool prepareCommandLine();
+        void showMessage(const QString &message);
+        TabWidget* tabWidget() const;
+        QString resolveCommand(const QString &name) const;
+        void switchToBuffer(const QString &buffer);
+        void runAction(const VimConfig::Action &action, QKeyEvent *event,
+                int count);
+        void runArgumentAction(VimConfig::ActionType action,
+                const QString &key, int count);
+        void setOption(const QString &assignment);
+        void applyConfig();
+        void openTabPicker();
+        void handleSelectionKey(const QString &key);
+        void zoom(int steps, bool reset);
+        void searchTabs(const QString &text);
+        void scrollToTop();
+        void scrollToBottom();
+        void stopFollowingBottom();
+        void jumpToOutline(const QString &kind, int count);
+        void openOutline();
+        VimMarks::Position currentPosition() const;
+        void recordJump();
+        void jumpOlder();
+        void jumpNewer();
+        void jumpTo(const VimMarks::Position &target);
+        const VimUrlMatcher::Verdict& verdictFor(WebPage *page);
+        void followPageLink(const QString &rel);
+        QString pageLinkArguments(const QString &rel) const;
+        int takeCount();
+        static bool isScrollAction(VimConfig::ActionType type);
+        static bool isZoomAction(VimConfig::ActionType type);
+        static bool isOutlineMotion(VimConfig::ActionType type);
+        void scrollSteps(int step_hor, int step_vert, int count,
+                QKeyEvent *event);
+        void replayMacro(QChar name, int count);
+        void beginBatch();
+        void endBatch();
+        void flushBatch();
+        void flushBatchScroll();
+        void flushBatchTabs();
 
-        static const int m_single_step;
-        static const int m_single_step_interval;
-        static const int m_num_scroll_steps;
-        bool m_g_pressed;
+        static const QString m_config_file_name;
+        static const int m_max_count;
+        static const int m_max_replay_steps;
+        static const int m_max_replay_depth;
+        static const int m_zoom_interval;
+        static const int m_max_follow_time;
+        static const int m_max_key_silence;
+        static const int m_max_outline_text;
+        bool m_started;
+        QString m_settings_path;
+        VimConfigPtr m_config;
+        VimConfigLoader m_config_loader;
+        QString m_pending_keys;
+        VimConfig::ActionType m_pending_argument;
+        int m_scroll_key;
         bool m_scroll_active;
         int m_scroll_hor;
         int m_scroll_vert;
         QTimer m_scroll_timer;
+        /* Pages under ':scrollbind', scrolling any of them scrolls the
+         * others, see 'syncBoundPages'.
+         */
+        QSet<WebPage *> m_scroll_bound;
+        /* Steps done in the current scroll, a key press is a whole number
+         * of 'numScrollSteps'.
+         */
+        int m_scroll_step_i;
+        /* Steps of the current cycle, fewer than 'numScrollSteps' when the
+         * renderer falls behind.
+         */
+        int m_scroll_steps;
+        /* Each page renders at its own pace. */
+        QHash<WebPage *, VimScrollQuality> m_scroll_quality;
+        QElapsedTimer m_last_key_press;
         WebPage *m_page;
+        VimCompleter m_completer;
+        QPointer<VimCommandLine> m_command_line;
+        VimTabDiscarder m_tab_discarder;
+        VimScrollMemory m_scroll_memory;
+        VimMarks m_marks;
+        QHash<WebPage *, VimUrlMatcher::Verdict> m_page_verdicts;
+        /* Pages whose loads prefetch their next page, see 'Paging'. */
+        QHash<WebPage *, Paging> m_paging_pages;
+        VimMacros m_macros;
+        int m_count;
+        QChar m_last_macro_register;
+        int m_replay_budget;
+        int m_replay_depth;
+        Batch m_batch;
+        VimThumbnailCache m_thumbnails;
+        QPointer<VimTabPicker> m_tab_picker;
+        VimSelection m_selection;
+        /* Zoom changes not applied yet, see 'zoom'. */
+        WebPage *m_zoom_page;
+        int m_zoom_steps;
+        bool m_zoom_reset;
+        QTimer m_zoom_timer;
+        VimTextIndex m_text_index;
+        QPointer<VimSearchResults> m_search_results;
+        QString m_search_text;
+        /* View of a matching tab still loading, searched once it is done. */
+        QPointer<WebView> m_find_view;
+        /* Page whose bottom 'G' follows, see 'followBottom'. */
+        WebPage *m_follow_page;
+        QTimer m_follow_timer;
+        QElapsedTimer m_follow_time;
+        VimSessionRecorder m_session_recorder;
+        QPointer<VimOutlinePicker> m_outline_picker;
 };
 
 #endif
@@ -0,0 +1,82 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_MACROS_H
+#define VIM_MACROS_H
+
+#include "VimConfig.h"
+
+#include <QChar>
+#include <QVector>
+
+/* Macro registers ('a'-'z').
+ *
+ * A macro is the list of actions the engine ran while recording, with
+ * their argument and count, not the keys typed: replaying it does not go
+ * through the keymap again, so remapping keys afterwards does not change
+ * what a macro does. Recording into 'A'-'Z' appends to the register, like
+ * vim.
+ */
+class VimMacros
+{
+    public:
+        struct Step {
+            VimConfig::Action action;
+            QString argument;
+            int count;
+        };
+
+        VimMacros();
+
+        bool startRecording(QChar name);
+        void stopRecording();
+        void record(const Step &step);
+        QVector<Step> macro(QChar name) const;
+
+        bool isRecording() const
+        {
+            return !m_recording_register.isNull();
+        }
+
+        QChar recordingRegister() const
+        {
+            return m_recording_register;
+        }
+
+#ifdef VIM_PLUGIN_TESTS
+        void clear()
+        {
+            for (QVector<Step> &steps : m_registers)
+                steps.clear();
+            m_recording.clear();
+            m_recording_register = QChar();
+            m_append = false;
+        }
+#endif
+
+    private:
+        static int registerIndex(QChar name);
+
+        static const int m_num_registers = 26;
+        QVector<Step> m_registers[m_num_registers];
+        QVector<Step> m_recording;
+        QChar m_recording_register;
+        bool m_append;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_MARKS_H
+#define VIM_MARKS_H
+
+#include "VimRingBuffer.h"
+
+#include <QFile>
+#include <QPointF>
+#include <QString>
+#include <QUrl>
+
+/* Vim marks and jumplist.
+ *
+ * Local marks ('a'-'z') and the jumplist only live in memory in fixed size
+ * ring buffers. Global marks ('A'-'Z') are kept in a small fixed layout file
+ * that is memory mapped the first time a global mark is used, so reading or
+ * setting one is just a copy from/to the mapping.
+ */
+class VimMarks
+{
+    public:
+        struct Position {
+            QUrl url;
+            QPointF pos;
+        };
+
+        VimMarks();
+        ~VimMarks();
+
+        void setSettingsPath(const QString &settings_path);
+
+        bool setMark(QChar name, const Position &position);
+        bool mark(QChar name, const QUrl &cur_url, Position *res);
+
+        void recordJump(const Position &origin);
+        bool jumpOlder(const Position &current, Position *res);
+        bool jumpNewer(Position *res);
+        bool previousContext(const Position &current, Position *res);
+
+        static bool sameDocument(const QUrl &a, const QUrl &b);
+
+#ifdef VIM_PLUGIN_TESTS
+        void clear()
+        {
+            m_local_marks.clear();
+            m_jumps.clear();
+            m_jump_i = 0;
+            m_has_last_jump = false;
+        }
+
+        QString globalMarksFilePath() const
+        {
+            return m_global_file.fileName();
+        }
+
+        int jumpCount() const
+        {
+            return m_jumps.size();
+        }
+#endif
+
+    private:
+        struct LocalMark {
+            QChar name;
+            Position position;
+        };
+
+        bool mapGlobalMarks();
+        void writeGlobalMark(int slot, const Position &position);
+        bool readGlobalMark(int slot, Position *res) const;
+
+        static const QString m_global_file_name;
+        static const int m_global_slot_size;
+        static const int m_global_header_size;
+        VimRingBuffer<LocalMark, 128> m_local_marks;
+        VimRingBuffer<Position, 100> m_jumps;
+        int m_jump_i;
+        Position m_last_jump;
+        bool m_has_last_jump;
+        QString m_settings_path;
+        QFile m_global_file;
+        uchar *m_global_map;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_OUTLINE_PICKER_H
+#define VIM_OUTLINE_PICKER_H
+
+#include <QListWidget>
+#include <QVariantList>
+
+/* 'gO' outline of the page over the web view: headings indented by level
+ * and landmarks, in document order. j/k or the arrows move, typing jumps
+ * to a matching entry, Enter scrolls the page there, Esc closes.
+ */
+class VimOutlinePicker : public QListWidget
+{
+    Q_OBJECT
+
+    public:
+        explicit VimOutlinePicker(QWidget *parent);
+
+        /* 'entries' are [level, text] lists, level 0 for landmarks. */
+        void open(const QVariantList &entries);
+
+    public slots:
+        void leave();
+
+    signals:
+        void entrySelected(int index);
+
+    protected:
+        void keyPressEvent(QKeyEvent *event);
+        void focusOutEvent(QFocusEvent *event);
+};
+
+#endif
@@ -0,0 +1,55 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_PAGE_HELPER_H
+#define VIM_PAGE_HELPER_H
+
+#include <QString>
+#include <QVariant>
+
+#include <functional>
+
+class WebPage;
+
+/* Installs data/vimhelper.js in every page and calls into it.
+ *
+ * The helper lives in QupZilla's isolated JavaScript world and keeps state
+ * across calls, like the element hjkl scrolls, so key presses only send a
+ * short call instead of walking the DOM again.
+ */
+class VimPageHelper
+{
+    public:
+        static void install();
+        static void uninstall();
+
+        /* 'call' is a method of the helper with its arguments, like
+         * "scrollBy(0, 9)".
+         */
+        static void run(WebPage *page, const QString &call);
+        static void run(WebPage *page, const QString &call,
+                const std::function<void (const QVariant &)> &callback);
+
+    private:
+        static QString source();
+        static QString expression(const QString &call);
+
+        static const QString m_script_name;
+};
+
+#endif
@@ -42,6 +42,9 @@ class VimPlugin : public QObject, public PluginInterface
         bool keyRelease(const Qz::ObjectName &type, QObject* obj,
                 QKeyEvent* event);
 
+        bool acceptNavigationRequest(WebPage *page, const QUrl &url,
+                QWebEnginePage::NavigationType type, bool isMainFrame);
+
 #ifdef VIM_PLUGIN_TESTS
         void init()
         {
@@ -0,0 +1,62 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_PREFIX_INDEX_H
+#define VIM_PREFIX_INDEX_H
+
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/* Sorted index of lowercase keys pointing to completion items. Items are
+ * added once, 'finalize' sorts the keys and from then on the index is only
+ * read, so a finalized index can be shared across threads.
+ */
+class VimPrefixIndex
+{
+    public:
+        struct Item {
+            QString text;
+            QString value;
+        };
+
+        void addItem(const Item &item, const QStringList &keys);
+        void finalize();
+
+        QVector<Item> complete(const QString &prefix, int limit) const;
+
+        int size() const
+        {
+            return m_items.size();
+        }
+
+        bool isEmpty() const
+        {
+            return m_items.isEmpty();
+        }
+
+        static QStringList keysForPage(const QString &title,
+                const QString &url);
+
+    private:
+        QVector<Item> m_items;
+        QVector<QPair<QString, int> > m_keys;
+};
+
+#endif
@@ -0,0 +1,88 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_RING_BUFFER_H
+#define VIM_RING_BUFFER_H
+
+/* Fixed capacity FIFO: appending to a full buffer drops the oldest item.
+ * Index 0 is the oldest item and 'size() - 1' the newest one.
+ */
+template <typename T, int N>
+class VimRingBuffer
+{
+    public:
+        VimRingBuffer()
+            : m_first(0)
+            , m_size(0)
+        {
+        }
+
+        void append(const T &item)
+        {
+            m_items[(m_first + m_size) % N] = item;
+            if (m_size < N)
+                ++m_size;
+            else
+                m_first = (m_first + 1) % N;
+        }
+
+        /* Drops the newest items so only the first 'size' remain. */
+        void truncate(int size)
+        {
+            if (size >= 0 && size < m_size)
+                m_size = size;
+        }
+
+        void clear()
+        {
+            m_first = 0;
+            m_size = 0;
+        }
+
+        const T& at(int i) const
+        {
+            return m_items[(m_first + i) % N];
+        }
+
+        T& operator[](int i)
+        {
+            return m_items[(m_first + i) % N];
+        }
+
+        int size() const
+        {
+            return m_size;
+        }
+
+        bool isEmpty() const
+        {
+            return 0 == m_size;
+        }
+
+        static int capacity()
+        {
+            return N;
+        }
+
+    private:
+        T m_items[N];
+        int m_first;
+        int m_size;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_SCROLL_MEMORY_H
+#define VIM_SCROLL_MEMORY_H
+
+#include <QCache>
+#include <QHash>
+#include <QObject>
+#include <QPointF>
+#include <QSizeF>
+#include <QUrl>
+
+class WebPage;
+
+/* Remembers where each URL was scrolled to when the user left it and puts
+ * the page back there on reload or back/forward. The restore is driven by
+ * the page's content size so it happens as soon as the page is tall enough,
+ * usually well before the load finishes.
+ *
+ * Until the new document commits, size changes still come from the one
+ * being left. That one is marked when the restore is armed and a restore
+ * landing on it is retried on the next size change instead.
+ */
+class VimScrollMemory : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit VimScrollMemory(QObject *parent = nullptr);
+
+        void remember(const QUrl &url, const QPointF &pos);
+        void restoreWhenReady(WebPage *page, const QUrl &url);
+        void restoreWhenReady(WebPage *page, const QUrl &url,
+                const QPointF &pos);
+        void cancelRestore(WebPage *page);
+        void cancelRestoreUnlessFor(WebPage *page, const QUrl &url);
+
+        bool contains(const QUrl &url) const
+        {
+            return m_positions.contains(key(url));
+        }
+
+        int size() const
+        {
+            return m_positions.size();
+        }
+
+        static int capacity()
+        {
+            return m_max_urls;
+        }
+
+    signals:
+        void restored(WebPage *page, const QPointF &pos);
+
+    private slots:
+        void contentsSizeChanged(const QSizeF &size);
+        void loadFinished();
+        void pageDestroyed(QObject *page);
+
+    private:
+        struct PendingRestore {
+            QString url_key;
+            QPointF pos;
+            /* A restore was sent and has not answered yet, and whether it
+             * was asked for again meanwhile.
+             */
+            bool in_flight;
+            bool retry;
+        };
+
+        static QString key(const QUrl &url);
+        void restore(WebPage *page);
+
+        static const int m_max_urls;
+        QCache<QString, QPointF> m_positions;
+        QHash<WebPage *, PendingRestore> m_pending;
+};
+
+#endif
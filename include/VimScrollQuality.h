@@ -0,0 +1,88 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_SCROLL_QUALITY_H
+#define VIM_SCROLL_QUALITY_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+/* How smoothly scrolls are animated, following how fast the renderer
+ * keeps up.
+ *
+ * The engine reports each scroll step it sends and each scroll position
+ * change the page reports back. The time from the oldest step not seen yet
+ * to the next position change is the lag of the renderer: when it stays
+ * above a few frames, steps are queued faster than they are painted and
+ * motion trails behind the key, so animations drop to fewer, larger steps
+ * and then to a single jump. Once the lag is back to about a frame they
+ * return to full smoothness.
+ */
+class VimScrollQuality
+{
+    public:
+        enum Mode {
+            Smooth,
+            Reduced,
+            Instant
+        };
+
+        VimScrollQuality();
+
+        /* Steps an animation of 'full_steps' steps takes in this mode. */
+        int steps(int full_steps) const;
+
+        void stepRequested();
+        /* 'frame_ms' is the interval between steps. */
+        void positionChanged(int frame_ms);
+        void reset();
+
+        Mode mode() const
+        {
+            return m_mode;
+        }
+
+        int averageLag() const
+        {
+            return m_average_lag;
+        }
+
+        QString summary() const;
+
+    private:
+        void setMode(Mode mode);
+
+        static const int m_min_samples;
+        static const int m_degrade_frames;
+        static const int m_recover_frames;
+        static const int m_max_lag;
+        Mode m_mode;
+        QElapsedTimer m_oldest_request;
+        int m_pending;
+        int m_average_lag;
+        int m_samples;
+        /* Counters since the last reset, for ':scrollstats'. */
+        int m_requested;
+        int m_observed;
+        int m_unobserved;
+        int m_max_seen_lag;
+        int m_reductions;
+        int m_recoveries;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_SEARCH_RESULTS_H
+#define VIM_SEARCH_RESULTS_H
+
+#include <QListWidget>
+#include <QPointer>
+
+class WebTab;
+
+/* ':tabsearch' matches over the web view, filled in as they are found:
+ * j/k or the arrows move, Enter jumps to the match, Esc closes.
+ */
+class VimSearchResults : public QListWidget
+{
+    Q_OBJECT
+
+    public:
+        explicit VimSearchResults(QWidget *parent);
+
+        void open();
+
+    public slots:
+        void addMatch(WebTab *tab, const QString &title,
+                const QString &snippet, int match_count);
+        void leave();
+
+    signals:
+        void matchSelected(WebTab *tab);
+
+    protected:
+        void keyPressEvent(QKeyEvent *event);
+        void focusOutEvent(QFocusEvent *event);
+
+    private:
+        QList<QPointer<WebTab> > m_tabs;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_SELECTION_H
+#define VIM_SELECTION_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+class WebPage;
+
+/* Caret and visual mode of a page.
+ *
+ * Motions are not sent one by one: they are buffered, runs of the same
+ * motion collapsed into a count, and sent to the page helper at most once
+ * per frame as a short string like "12l3w", where '0' is sent as '^' so it
+ * is not read as part of a count. The helper applies them
+ * without replying, so holding 'l' costs one script call per frame instead
+ * of one round trip per character.
+ */
+class VimSelection : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Mode {
+            Off,
+            Caret,
+            Visual
+        };
+
+        explicit VimSelection(QObject *parent = nullptr);
+
+        void enter(WebPage *page, Mode mode);
+        void leave();
+        void forgetPage(WebPage *page);
+
+        /* 'false' if 'motion' is not one of "hjklwb$0". */
+        bool move(QChar motion, int count);
+        void yank();
+
+        Mode mode() const
+        {
+            return m_mode;
+        }
+
+        WebPage* page() const
+        {
+            return m_page;
+        }
+
+        static bool isMotion(QChar key);
+
+    signals:
+        void yanked(int length);
+
+    private slots:
+        void flush();
+
+    private:
+        struct Motion {
+            QChar key;
+            int count;
+        };
+
+        QString modeName() const;
+
+        /* Frame time, the most motions wait before reaching the page. */
+        static const int m_flush_interval;
+        static const int m_max_motion_count;
+        Mode m_mode;
+        WebPage *m_page;
+        QVector<Motion> m_motions;
+        QTimer m_flush_timer;
+};
+
+#endif
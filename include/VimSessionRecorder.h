@@ -0,0 +1,106 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_SESSION_RECORDER_H
+#define VIM_SESSION_RECORDER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDataStream>
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+#include <QVector>
+
+class QIODevice;
+class QKeyEvent;
+class TabWidget;
+class WebPage;
+
+/* Records key sessions, for replaying real usage in performance tests.
+ * Keys typed into form fields and other editable elements are left out,
+ * they would put what the user wrote, passwords too, in the file.
+ *
+ * The file is a QDataStream: the magic number and format version, then
+ * one record per event, each a type byte and the milliseconds since the
+ * recording started followed by:
+ *
+ *   KeyPress, KeyRelease  qint32 key, quint32 modifiers, bool auto-repeat,
+ *                         QString text
+ *   Url                   QString url, written when keys go to a page
+ *                         with another URL than the previous key
+ *   Tabs                  quint16 tab count, quint16 current tab, written
+ *                         when the current tab changes
+ */
+class VimSessionRecorder : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum EventType {
+            KeyPress,
+            KeyRelease,
+            Url,
+            Tabs
+        };
+
+        struct Event {
+            EventType type;
+            quint32 time_ms;
+            int key;
+            Qt::KeyboardModifiers modifiers;
+            bool auto_repeat;
+            QString text;
+            QUrl url;
+            int tab_count;
+            int current_tab;
+        };
+
+        explicit VimSessionRecorder(QObject *parent = nullptr);
+
+        bool start(const QString &file_path, TabWidget *tab_widget,
+                QString *error);
+        /* Returns the number of events recorded. */
+        int stop();
+        void recordKey(WebPage *page, const QKeyEvent *event);
+
+        bool isRecording() const
+        {
+            return m_file.isOpen();
+        }
+
+        static QVector<Event> read(QIODevice *device, QString *error);
+
+    private slots:
+        void tabChanged();
+
+    private:
+        static bool isTyping(WebPage *page);
+        void write(EventType type);
+
+        static const quint32 m_magic;
+        static const quint16 m_version;
+        QFile m_file;
+        QDataStream m_stream;
+        QElapsedTimer m_clock;
+        QPointer<TabWidget> m_tab_widget;
+        QUrl m_last_url;
+        int m_count;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_TAB_DISCARDER_H
+#define VIM_TAB_DISCARDER_H
+
+#include "webtab.h"
+
+#include <QHash>
+#include <QObject>
+
+class TabWidget;
+
+/* Unloads the web page of background tabs while keeping the tab itself, and
+ * loads it back the next time the tab becomes current. Pinned tabs are
+ * left alone.
+ *
+ * The page of a discarded tab is replaced by an empty document standing at
+ * the same URL with the same title, so the tab, its location bar and the
+ * session keep reporting what it showed. Its history and zoom are kept
+ * here until it is restored.
+ */
+class VimTabDiscarder : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit VimTabDiscarder(QObject *parent = nullptr);
+
+        void watch(TabWidget *tab_widget);
+        int discard(TabWidget *tab_widget, int count);
+
+        bool isDiscarded(WebTab *tab) const
+        {
+            return m_discarded.contains(tab);
+        }
+
+        static qint64 rendererMemoryKb();
+
+    signals:
+        /* Emitted once the renderers had time to exit. 'reclaimed_kb' is
+         * negative when the memory could not be measured.
+         */
+        void discarded(int count, qint64 reclaimed_kb);
+
+    private slots:
+        void tabActivated(int index);
+        void tabDestroyed(QObject *tab);
+        void reportReclaimed();
+
+    private:
+        QList<WebTab *> discardCandidates(TabWidget *tab_widget) const;
+        void discardTab(WebTab *tab);
+        void restoreTab(WebTab *tab);
+
+        static const int m_report_delay;
+        QHash<WebTab *, qint64> m_last_activation;
+        QHash<WebTab *, WebTab::SavedTab> m_discarded;
+        qint64 m_memory_before_kb;
+        int m_pending_count;
+};
+
+#endif
@@ -0,0 +1,86 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_TAB_PICKER_H
+#define VIM_TAB_PICKER_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QListView>
+#include <QPixmap>
+#include <QPointer>
+#include <QStringList>
+
+class TabWidget;
+class VimThumbnailCache;
+class WebTab;
+
+/* Tabs of a window as they were when the picker opened. Previews are
+ * decoded only for the rows the view asks for, which are the visible ones.
+ */
+class VimTabPickerModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    public:
+        VimTabPickerModel(TabWidget *tab_widget,
+                const VimThumbnailCache *thumbnails, QObject *parent);
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const;
+        QVariant data(const QModelIndex &index, int role) const;
+
+    private slots:
+        void thumbnailCaptured(WebTab *tab);
+
+    private:
+        static const int m_max_decoded;
+        const VimThumbnailCache *m_thumbnails;
+        QList<QPointer<WebTab> > m_tabs;
+        QStringList m_titles;
+        mutable QCache<int, QPixmap> m_decoded;
+        QPixmap m_placeholder;
+};
+
+/* Grid of tab previews over the web view: hjkl or the arrows move, Enter
+ * switches to the selected tab, a digit to that tab, Esc closes.
+ */
+class VimTabPicker : public QListView
+{
+    Q_OBJECT
+
+    public:
+        VimTabPicker(TabWidget *tab_widget,
+                const VimThumbnailCache *thumbnails, QWidget *parent);
+
+        void open();
+
+    signals:
+        void tabSelected(int index);
+
+    protected:
+        void keyPressEvent(QKeyEvent *event);
+        void focusOutEvent(QFocusEvent *event);
+
+    private:
+        void select(int row);
+        void leave();
+
+        VimTabPickerModel m_model;
+};
+
+#endif
@@ -0,0 +1,112 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_TEXT_INDEX_H
+#define VIM_TEXT_INDEX_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+class WebPage;
+class WebTab;
+
+/* Text of every open tab, for ':tabsearch'.
+ *
+ * A page's visible text is read once, a moment after it finishes loading
+ * or changes URL, and kept qCompress'ed per tab; discarded tabs keep
+ * theirs. Searching only reads this cache, on worker threads, so it never
+ * runs script in background renderers nor blocks the UI thread, and
+ * matches are reported tab by tab as they are found.
+ */
+class VimTextIndex : public QObject
+{
+    Q_OBJECT
+
+    public:
+        struct Entry {
+            WebTab *tab;
+            QString title;
+            QByteArray text;
+        };
+
+        struct Match {
+            WebTab *tab;
+            QString title;
+            QString snippet;
+            int count;
+        };
+
+        explicit VimTextIndex(QObject *parent = nullptr);
+
+        void start();
+        void watchPage(WebPage *page);
+        void search(const QString &text);
+        void cancel();
+
+        bool contains(WebTab *tab) const
+        {
+            return m_entries.contains(tab);
+        }
+
+        int count() const
+        {
+            return m_entries.size();
+        }
+
+        qint64 compressedBytes() const;
+
+    signals:
+        void found(WebTab *tab, const QString &title, const QString &snippet,
+                int count);
+        void searchFinished(const QString &text, int matches);
+
+    private slots:
+        void pageChanged();
+        void extractNext();
+        void compressed();
+        void matchReady(int index);
+        void searchDone();
+        void tabDestroyed(QObject *tab);
+
+    private:
+        void enqueue(WebPage *page);
+        void store(WebPage *page, const QString &text);
+        static WebTab* tabOf(WebPage *page);
+        static QByteArray compress(const QString &text);
+
+        /* Pause before reading a page, letting late content settle, and
+         * between two pages of the queue.
+         */
+        static const int m_extract_delay;
+        static const int m_max_text_length;
+        bool m_started;
+        QHash<WebTab *, Entry> m_entries;
+        QList<QPointer<WebPage> > m_queue;
+        QTimer m_extract_timer;
+        QHash<QFutureWatcher<QByteArray> *, Entry> m_compressing;
+        QFutureWatcher<Match> m_search;
+        QString m_search_text;
+        int m_search_matches;
+};
+
+#endif
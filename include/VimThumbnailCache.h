@@ -0,0 +1,103 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_THUMBNAIL_CACHE_H
+#define VIM_THUMBNAIL_CACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QSize>
+
+class TabWidget;
+class WebTab;
+
+/* Page previews for the tab picker.
+ *
+ * A tab is grabbed as it is hidden for another one to become current,
+ * while its view still holds its last frame, downscaled and JPEG
+ * compressed in a worker thread. Only the compressed bytes are kept,
+ * in an LRU cache bounded by a byte budget, so hundreds of tabs cost a few
+ * megabytes and showing a preview never touches the tab's page.
+ */
+class VimThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit VimThumbnailCache(QObject *parent = nullptr);
+
+        void watch(TabWidget *tab_widget);
+        void setBudget(int bytes);
+        void capture(WebTab *tab);
+        QImage thumbnail(WebTab *tab) const;
+
+        bool contains(WebTab *tab) const
+        {
+            return m_thumbnails.contains(tab);
+        }
+
+        int count() const
+        {
+            return m_thumbnails.count();
+        }
+
+        int totalCost() const
+        {
+            return m_thumbnails.totalCost();
+        }
+
+        int budget() const
+        {
+            return m_thumbnails.maxCost();
+        }
+
+        static QSize thumbnailSize()
+        {
+            return m_thumbnail_size;
+        }
+
+    signals:
+        void captured(WebTab *tab);
+
+    protected:
+        bool eventFilter(QObject *obj, QEvent *event);
+
+    private slots:
+        void tabActivated(int index);
+        void tabDestroyed(QObject *tab);
+        void tabWidgetDestroyed(QObject *tab_widget);
+        void encoded();
+
+    private:
+        static QByteArray encode(const QImage &image);
+
+        static const QSize m_thumbnail_size;
+        static const int m_jpeg_quality;
+        QCache<WebTab *, QByteArray> m_thumbnails;
+        QHash<TabWidget *, QPointer<WebTab> > m_current_tabs;
+        QHash<QFutureWatcher<QByteArray> *, WebTab *> m_encoding;
+        QSet<WebTab *> m_known_tabs;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_URL_MATCHER_H
+#define VIM_URL_MATCHER_H
+
+#include <QHash>
+#include <QList>
+#include <QRegularExpression>
+#include <QString>
+#include <QUrl>
+
+/* Exclusion rules, Vimium style. A rule is an URL pattern where '*' matches
+ * anything, plus optional "pass keys" left to the page. A matching rule
+ * without pass keys disables the plugin on the page. Hosts match whatever
+ * their case, like URLs do.
+ *
+ * Rules are compiled once: the ones with a literal host are bucketed by
+ * host, all others are merged into one regular expression per set of pass
+ * keys. Matching an URL is then a hash lookup plus a handful of regular
+ * expression matches, however many rules there are.
+ */
+class VimUrlMatcher
+{
+    public:
+        struct Verdict {
+            bool disabled;
+            QString pass_keys;
+        };
+
+        VimUrlMatcher();
+
+        bool addRule(const QString &pattern, const QString &pass_keys);
+        void finalize();
+
+        Verdict match(const QUrl &url) const;
+
+        int ruleCount() const
+        {
+            return m_rule_count;
+        }
+
+    private:
+        struct Rule {
+            QRegularExpression regexp;
+            QString pass_keys;
+        };
+
+        struct Group {
+            QStringList patterns;
+            QRegularExpression regexp;
+            QString pass_keys;
+        };
+
+        static QString withLowerCaseHost(const QString &pattern);
+        static QString toRegExp(const QString &pattern);
+        static void merge(Verdict *verdict, const QString &pass_keys);
+
+        QHash<QString, QList<Rule> > m_host_rules;
+        QHash<QString, Group> m_groups;
+        int m_rule_count;
+};
+
+#endif
@@ -0,0 +1,282 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimCommandLine.h"
+
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QVBoxLayout>
+
+const int VimCommandLine::m_max_completions = 10;
+const int VimCommandLine::m_max_history = 50;
+const int VimCommandLine::m_message_timeout = 3000;
+
+VimCommandLine::VimCommandLine(VimCompleter *completer, QWidget *parent)
+    : QWidget(parent)
+    , m_completer(completer)
+    , m_argument_sources()
+    , m_wild_menu()
+    , m_prompt(":")
+    , m_edit()
+    , m_message_timer()
+    , m_completion_base()
+    , m_completions()
+    , m_completion_i(-1)
+    , m_completion_waiting(false)
+    , m_history()
+    , m_history_i(0)
+{
+    setAutoFillBackground(true);
+
+    QHBoxLayout *edit_layout = new QHBoxLayout();
+    edit_layout->setContentsMargins(0, 0, 0, 0);
+    edit_layout->setSpacing(0);
+    edit_layout->addWidget(&m_prompt);
+    edit_layout->addWidget(&m_edit);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->setSpacing(0);
+    layout->addWidget(&m_wild_menu);
+    layout->addLayout(edit_layout);
+
+    m_edit.setFrame(false);
+    m_edit.installEventFilter(this);
+    m_wild_menu.setTextFormat(Qt::RichText);
+    m_wild_menu.hide();
+
+    m_message_timer.setSingleShot(true);
+    m_message_timer.setInterval(m_message_timeout);
+    connect(&m_message_timer, SIGNAL(timeout()), this, SLOT(leave()));
+    connect(&m_edit, SIGNAL(textEdited(QString)),
+            this, SLOT(resetCompletion()));
+    connect(m_completer, SIGNAL(refreshed()),
+            this, SLOT(completerRefreshed()));
+
+    if (parent)
+        parent->installEventFilter(this);
+
+    hide();
+}
+
+void VimCommandLine::setArgumentSources(const QString &command,
+        const QList<VimCompleter::Source> &sources)
+{
+    m_argument_sources.insert(command, sources);
+}
+
+void VimCommandLine::open()
+{
+    m_message_timer.stop();
+    m_prompt.setText(":");
+    m_prompt.show();
+    m_edit.setReadOnly(false);
+    m_edit.clear();
+    m_history_i = m_history.size();
+    resetCompletion();
+
+    placeAtBottom();
+    show();
+    raise();
+    m_edit.setFocus();
+}
+
+void VimCommandLine::showMessage(const QString &message)
+{
+    resetCompletion();
+    m_prompt.hide();
+    m_edit.setReadOnly(true);
+    m_edit.setText(message);
+
+    placeAtBottom();
+    show();
+    raise();
+    m_message_timer.start();
+}
+
+bool VimCommandLine::eventFilter(QObject *obj, QEvent *event)
+{
+    if (obj == parent()) {
+        if (QEvent::Resize == event->type() && isVisible())
+            placeAtBottom();
+        return false;
+    }
+
+    if (obj != &m_edit || QEvent::KeyPress != event->type())
+        return false;
+
+    QKeyEvent *key_event = static_cast<QKeyEvent *>(event);
+    switch (key_event->key()) {
+        case Qt::Key_Escape:
+            leave();
+            return true;
+
+        case Qt::Key_Return:
+        case Qt::Key_Enter: {
+            const QString command = m_edit.text().trimmed();
+            leave();
+            if (!command.isEmpty()) {
+                m_history.removeAll(command);
+                m_history.append(command);
+                if (m_history.size() > m_max_history)
+                    m_history.removeFirst();
+                emit commandEntered(command);
+            }
+            return true;
+        }
+
+        case Qt::Key_Tab:
+            complete(false);
+            return true;
+
+        case Qt::Key_Backtab:
+            complete(true);
+            return true;
+
+        case Qt::Key_Up:
+            browseHistory(-1);
+            return true;
+
+        case Qt::Key_Down:
+            browseHistory(1);
+            return true;
+
+        case Qt::Key_Backspace:
+            /* Like vim, erasing the empty line leaves the command line. */
+            if (m_edit.text().isEmpty()) {
+                leave();
+                return true;
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+void VimCommandLine::leave()
+{
+    m_message_timer.stop();
+    resetCompletion();
+    hide();
+
+    if (parentWidget())
+        parentWidget()->setFocus();
+}
+
+void VimCommandLine::resetCompletion()
+{
+    m_completion_base.clear();
+    m_completions.clear();
+    m_completion_i = -1;
+    m_completion_waiting = false;
+    m_wild_menu.hide();
+}
+
+void VimCommandLine::completerRefreshed()
+{
+    if (m_completion_waiting && isVisible() && m_completion_i < 0) {
+        m_completion_waiting = false;
+        complete(false);
+    }
+}
+
+void VimCommandLine::complete(bool backwards)
+{
+    /* The first Tab computes the candidates for what was typed and the
+     * following ones only cycle through them, like vim's wildmenu.
+     */
+    if (m_completion_i < 0) {
+        const QString text = m_edit.text();
+        const int space_i = text.indexOf(' ');
+
+        QList<VimCompleter::Source> sources;
+        QString prefix;
+        if (space_i < 0) {
+            sources << VimCompleter::Commands;
+            prefix = text;
+            m_completion_base.clear();
+        }
+        else {
+            sources = m_argument_sources.value(text.left(space_i));
+            prefix = text.mid(space_i + 1).trimmed();
+            m_completion_base = text.left(space_i + 1);
+        }
+
+        /* History is only loaded for the first command completing it. */
+        const bool history_loading = sources.contains(VimCompleter::History)
+            && !m_completer->isHistoryLoaded();
+        if (history_loading)
+            m_completer->requestHistory();
+
+        m_completions.clear();
+        foreach (VimCompleter::Source source, sources) {
+            const int left = m_max_completions - m_completions.size();
+            foreach (const VimPrefixIndex::Item &item,
+                    m_completer->complete(source, prefix, left)) {
+                if (!m_completions.contains(item.text))
+                    m_completions.append(item.text);
+            }
+        }
+
+        if (m_completions.isEmpty()) {
+            m_completion_waiting = history_loading;
+            return;
+        }
+        m_completion_i = backwards ? m_completions.size() : -1;
+    }
+
+    const int count = m_completions.size();
+    m_completion_i = (m_completion_i + (backwards ? -1 : 1) + count) % count;
+    m_edit.setText(m_completion_base + m_completions.at(m_completion_i));
+    showWildMenu();
+}
+
+void VimCommandLine::showWildMenu()
+{
+    QStringList entries;
+    for (int i = 0; i < m_completions.size(); ++i) {
+        const QString entry = m_completions.at(i).toHtmlEscaped();
+        entries << (i == m_completion_i ? QString("<b>%1</b>").arg(entry)
+                                        : entry);
+    }
+    m_wild_menu.setText(entries.join("&nbsp;&nbsp;"));
+    m_wild_menu.show();
+    placeAtBottom();
+}
+
+void VimCommandLine::browseHistory(int direction)
+{
+    if (m_history.isEmpty())
+        return;
+
+    m_history_i = qBound(0, m_history_i + direction, m_history.size());
+    m_edit.setText(m_history.value(m_history_i));
+    resetCompletion();
+}
+
+void VimCommandLine::placeAtBottom()
+{
+    if (!parentWidget())
+        return;
+
+    const QRect area = parentWidget()->rect();
+    const int height = sizeHint().height();
+    setGeometry(0, area.height() - height, area.width(), height);
+}
@@ -0,0 +1,274 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimCompleter.h"
+
+#include <QSqlQuery>
+#include <QtConcurrent>
+
+#include "mainapplication.h"
+#include "bookmarks.h"
+#include "bookmarkitem.h"
+#include "history.h"
+#include "sqldatabase.h"
+#include "tabwidget.h"
+#include "webtab.h"
+
+const int VimCompleter::m_max_history_entries = 20000;
+const int VimCompleter::m_max_recent_history = 500;
+
+VimCompleter::VimCompleter(QObject *parent)
+    : QObject(parent)
+    , m_commands()
+    , m_indexes()
+    , m_watcher()
+    , m_sources_connected(false)
+    , m_bookmarks_dirty(true)
+    , m_history_dirty(true)
+    , m_history_wanted(false)
+    , m_recent_history()
+    , m_refresh_pending(false)
+    , m_pending_tab_widget()
+    , m_tab_widget()
+{
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(indexesBuilt()));
+}
+
+void VimCompleter::setCommands(const QStringList &commands)
+{
+    m_commands = VimPrefixIndex();
+    foreach (const QString &command, commands)
+        m_commands.addItem({command, command}, QStringList(command));
+    m_commands.finalize();
+}
+
+void VimCompleter::refresh(TabWidget *tab_widget)
+{
+    if (!tab_widget)
+        return;
+    m_tab_widget = tab_widget;
+
+    if (m_watcher.isRunning()) {
+        m_refresh_pending = true;
+        m_pending_tab_widget = tab_widget;
+        return;
+    }
+
+    connectSources();
+
+    /* Only the snapshot of the browser state is taken in the UI thread,
+     * sorting and history querying happen in the worker.
+     */
+    QVector<PageEntry> tabs;
+    foreach (WebTab *tab, tab_widget->allTabs())
+        tabs.append({tab->title(), tab->url().toString()});
+
+    QVector<PageEntry> bookmarks;
+    const bool build_bookmarks = m_bookmarks_dirty;
+    if (build_bookmarks) {
+        QList<BookmarkItem *> folders;
+        folders.append(mApp->bookmarks()->rootItem());
+        while (!folders.isEmpty()) {
+            BookmarkItem *folder = folders.takeFirst();
+            foreach (BookmarkItem *item, folder->children()) {
+                if (item->isUrl())
+                    bookmarks.append({item->title(), item->urlString()});
+                else if (item->isFolder())
+                    folders.append(item);
+            }
+        }
+    }
+
+    /* A full query covers the recent pages too. */
+    const bool build_history = m_history_wanted && m_history_dirty;
+    if (build_history)
+        m_recent_history.clear();
+    m_bookmarks_dirty = false;
+    if (m_history_wanted)
+        m_history_dirty = false;
+
+    /* An empty bookmark snapshot with 'build_bookmarks' set would wipe the
+     * previous index, so the previous one is only reused when unchanged.
+     */
+    IndexesPtr previous = m_indexes;
+    if (build_bookmarks && previous) {
+        Indexes *without_bookmarks = new Indexes(*previous);
+        without_bookmarks->bookmarks = VimPrefixIndex();
+        previous = IndexesPtr(without_bookmarks);
+    }
+
+    m_watcher.setFuture(QtConcurrent::run(&VimCompleter::buildIndexes,
+                tabs, bookmarks, build_history, m_recent_history, previous));
+}
+
+void VimCompleter::requestHistory()
+{
+    if (m_history_wanted)
+        return;
+
+    m_history_wanted = true;
+    refresh(m_tab_widget);
+}
+
+QVector<VimPrefixIndex::Item> VimCompleter::complete(Source source,
+        const QString &prefix, int limit) const
+{
+    if (Commands == source)
+        return m_commands.complete(prefix, limit);
+
+    if (!m_indexes)
+        return QVector<VimPrefixIndex::Item>();
+
+    switch (source) {
+        case Tabs:
+            return m_indexes->tabs.complete(prefix, limit);
+        case Bookmarks:
+            return m_indexes->bookmarks.complete(prefix, limit);
+        case History: {
+            QVector<VimPrefixIndex::Item> res =
+                m_indexes->recent_history.complete(prefix, limit);
+            foreach (const VimPrefixIndex::Item &item,
+                    m_indexes->history.complete(prefix, limit)) {
+                if (res.size() >= limit)
+                    break;
+                bool seen = false;
+                foreach (const VimPrefixIndex::Item &recent, res)
+                    seen = seen || recent.value == item.value;
+                if (!seen)
+                    res.append(item);
+            }
+            return res;
+        }
+        default:
+            return QVector<VimPrefixIndex::Item>();
+    }
+}
+
+void VimCompleter::indexesBuilt()
+{
+    m_indexes = m_watcher.result();
+    emit refreshed();
+
+    if (m_refresh_pending) {
+        m_refresh_pending = false;
+        refresh(m_pending_tab_widget);
+    }
+}
+
+void VimCompleter::invalidateBookmarks()
+{
+    m_bookmarks_dirty = true;
+}
+
+void VimCompleter::invalidateHistory()
+{
+    m_history_dirty = true;
+}
+
+void VimCompleter::addHistoryEntry(const HistoryEntry &entry)
+{
+    if (!m_history_wanted || m_history_dirty)
+        return;
+
+    const QString url = entry.urlString;
+    for (int i = 0; i < m_recent_history.size(); ++i) {
+        if (m_recent_history.at(i).url == url) {
+            m_recent_history.remove(i);
+            break;
+        }
+    }
+    m_recent_history.prepend({entry.title, url});
+    if (m_recent_history.size() > m_max_recent_history)
+        m_recent_history.removeLast();
+}
+
+VimCompleter::IndexesPtr VimCompleter::buildIndexes(
+        const QVector<PageEntry> &tabs, const QVector<PageEntry> &bookmarks,
+        bool build_history, const QVector<PageEntry> &recent_history,
+        IndexesPtr previous)
+{
+    Indexes *indexes = previous ? new Indexes(*previous) : new Indexes();
+
+    indexes->tabs = VimPrefixIndex();
+    for (int i = 0; i < tabs.size(); ++i) {
+        const PageEntry &tab = tabs.at(i);
+        /* Tabs are completed as "<number>: <title>" so ':buffer' can
+         * parse the tab number back from the completed text.
+         */
+        const QString text = QString("%1: %2").arg(i + 1).arg(tab.title);
+        QStringList keys = VimPrefixIndex::keysForPage(tab.title, tab.url);
+        keys << QString::number(i + 1);
+        indexes->tabs.addItem({text, QString::number(i)}, keys);
+    }
+    indexes->tabs.finalize();
+
+    if (!bookmarks.isEmpty()) {
+        indexes->bookmarks = VimPrefixIndex();
+        foreach (const PageEntry &bookmark, bookmarks) {
+            indexes->bookmarks.addItem({bookmark.url, bookmark.url},
+                    VimPrefixIndex::keysForPage(bookmark.title, bookmark.url));
+        }
+        indexes->bookmarks.finalize();
+    }
+
+    if (build_history) {
+        indexes->history = VimPrefixIndex();
+        /* SqlDatabase hands out a connection bound to the calling thread. */
+        QSqlQuery query(SqlDatabase::instance()->database());
+        query.prepare("SELECT title, url FROM history "
+                      "ORDER BY count DESC LIMIT ?");
+        query.addBindValue(m_max_history_entries);
+        query.exec();
+        while (query.next()) {
+            const QString title = query.value(0).toString();
+            const QString url = query.value(1).toString();
+            indexes->history.addItem({url, url},
+                    VimPrefixIndex::keysForPage(title, url));
+        }
+        indexes->history.finalize();
+    }
+
+    indexes->recent_history = VimPrefixIndex();
+    foreach (const PageEntry &page, recent_history) {
+        indexes->recent_history.addItem({page.url, page.url},
+                VimPrefixIndex::keysForPage(page.title, page.url));
+    }
+    indexes->recent_history.finalize();
+
+    return IndexesPtr(indexes);
+}
+
+void VimCompleter::connectSources()
+{
+    if (m_sources_connected)
+        return;
+    m_sources_connected = true;
+
+    connect(mApp->bookmarks(), SIGNAL(bookmarkAdded(BookmarkItem*)),
+            this, SLOT(invalidateBookmarks()));
+    connect(mApp->bookmarks(), SIGNAL(bookmarkRemoved(BookmarkItem*)),
+            this, SLOT(invalidateBookmarks()));
+    connect(mApp->bookmarks(), SIGNAL(bookmarkChanged(BookmarkItem*)),
+            this, SLOT(invalidateBookmarks()));
+    connect(mApp->history(), SIGNAL(historyEntryAdded(HistoryEntry)),
+            this, SLOT(addHistoryEntry(HistoryEntry)));
+    connect(mApp->history(), SIGNAL(historyEntryDeleted(HistoryEntry)),
+            this, SLOT(invalidateHistory()));
+    connect(mApp->history(), SIGNAL(resetHistory()),
+            this, SLOT(invalidateHistory()));
+}
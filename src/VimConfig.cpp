@@ -0,0 +1,365 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimConfig.h"
+
+#include <QKeyEvent>
+
+/* The built-in bindings are compiled from source like any user config, a
+ * user config is applied on top of them.
+ */
+const char *const VimConfig::m_default_source =
+    "map h scrollLeft\n"
+    "map j scrollDown\n"
+    "map k scrollUp\n"
+    "map l scrollRight\n"
+    "map d scrollHalfPageDown\n"
+    "map u scrollHalfPageUp\n"
+    "map gg scrollToTop\n"
+    "map G scrollToBottom\n"
+    "map r reload\n"
+    "map K nextTab\n"
+    "map J previousTab\n"
+    "map x removeTab\n"
+    "map X restoreTab\n"
+    "map : enterCommandLine\n"
+    "map m setMark\n"
+    "map ` jumpToMark\n"
+    "map ' jumpToMark\n"
+    "map <C-o> jumpOlder\n"
+    "map <C-i> jumpNewer\n"
+    "map ]] nextPage\n"
+    "map [[ previousPage\n"
+    "map q recordMacro\n"
+    "map @ replayMacro\n"
+    "map T tabPicker\n"
+    "map c caretMode\n"
+    "map v visualMode\n"
+    "map zi zoomIn\n"
+    "map zo zoomOut\n"
+    "map z0 zoomReset\n"
+    "map ]h nextHeading\n"
+    "map [h previousHeading\n"
+    "map ]l nextLandmark\n"
+    "map [l previousLandmark\n"
+    "map ]p nextParagraph\n"
+    "map [p previousParagraph\n"
+    "map gO outline\n";
+
+struct VimOptionSpec {
+    const char *name;
+    int default_value;
+    int min;
+    int max;
+};
+
+static const VimOptionSpec vim_options[] = {
+    {"scrollstep", 9, 1, 1000},
+    {"scrollinterval", 15, 1, 1000},
+    {"scrollsteps", 7, 1, 100},
+    {"prefetch", 1, 0, 1},
+    /* Kilobytes of compressed tab previews kept for the tab picker. */
+    {"thumbnailbudget", 8192, 256, 262144},
+    /* Milliseconds 'G' keeps following the bottom once the content stops
+     * growing, 0 to stop at the first bottom reached.
+     */
+    {"followbottom", 2000, 0, 60000},
+    /* Fewer, larger scroll steps while the renderer cannot keep up. */
+    {"adaptivescroll", 1, 0, 1}
+};
+
+struct VimStringOptionSpec {
+    const char *name;
+    const char *default_value;
+};
+
+/* Comma separated link texts for ']]' and '[[', tried in order. */
+static const VimStringOptionSpec vim_string_options[] = {
+    {"nextpatterns", "next,more,newer,>,\u203a,\u2192,\u00bb,\u226b,>>,"
+        "weiter,suivant,siguiente,pr\u00f3xima,pr\u00f3ximo,successivo,"
+        "\u6b21\u3078,\u4e0b\u4e00\u9875,"
+        "\u0441\u043b\u0435\u0434\u0443\u044e\u0449\u0430\u044f"},
+    {"previouspatterns", "prev,previous,back,older,<,\u2039,\u2190,\u00ab,"
+        "\u226a,<<,zur\u00fcck,pr\u00e9c\u00e9dent,anterior,precedente,"
+        "\u524d\u3078,\u4e0a\u4e00\u9875,"
+        "\u043f\u0440\u0435\u0434\u044b\u0434\u0443\u0449\u0430\u044f"}
+};
+
+static const QHash<QString, VimConfig::ActionType>& actionNames()
+{
+    static const QHash<QString, VimConfig::ActionType> names = {
+        {"scrollLeft", VimConfig::ScrollLeft},
+        {"scrollDown", VimConfig::ScrollDown},
+        {"scrollUp", VimConfig::ScrollUp},
+        {"scrollRight", VimConfig::ScrollRight},
+        {"scrollHalfPageDown", VimConfig::ScrollHalfPageDown},
+        {"scrollHalfPageUp", VimConfig::ScrollHalfPageUp},
+        {"scrollToTop", VimConfig::ScrollToTop},
+        {"scrollToBottom", VimConfig::ScrollToBottom},
+        {"reload", VimConfig::Reload},
+        {"nextTab", VimConfig::NextTab},
+        {"previousTab", VimConfig::PreviousTab},
+        {"removeTab", VimConfig::RemoveTab},
+        {"restoreTab", VimConfig::RestoreTab},
+        {"enterCommandLine", VimConfig::EnterCommandLine},
+        {"setMark", VimConfig::SetMark},
+        {"jumpToMark", VimConfig::JumpToMark},
+        {"jumpOlder", VimConfig::JumpOlder},
+        {"jumpNewer", VimConfig::JumpNewer},
+        {"nextPage", VimConfig::NextPage},
+        {"previousPage", VimConfig::PreviousPage},
+        {"recordMacro", VimConfig::RecordMacro},
+        {"replayMacro", VimConfig::ReplayMacro},
+        {"tabPicker", VimConfig::TabPicker},
+        {"caretMode", VimConfig::CaretMode},
+        {"visualMode", VimConfig::VisualMode},
+        {"zoomIn", VimConfig::ZoomIn},
+        {"zoomOut", VimConfig::ZoomOut},
+        {"zoomReset", VimConfig::ZoomReset},
+        {"nextHeading", VimConfig::NextHeading},
+        {"previousHeading", VimConfig::PreviousHeading},
+        {"nextLandmark", VimConfig::NextLandmark},
+        {"previousLandmark", VimConfig::PreviousLandmark},
+        {"nextParagraph", VimConfig::NextParagraph},
+        {"previousParagraph", VimConfig::PreviousParagraph},
+        {"outline", VimConfig::Outline}
+    };
+    return names;
+}
+
+VimConfig::VimConfig()
+    : m_keymap()
+    , m_prefixes()
+    , m_options()
+    , m_exclusions(new VimUrlMatcher())
+    , m_single_step(0)
+    , m_single_step_interval(0)
+    , m_num_scroll_steps(0)
+{
+    for (const VimOptionSpec &spec : vim_options)
+        m_options.insert(spec.name, spec.default_value);
+    for (const VimStringOptionSpec &spec : vim_string_options)
+        m_options.insert(spec.name, QString::fromUtf8(spec.default_value));
+}
+
+VimConfigPtr VimConfig::defaults()
+{
+    static const VimConfigPtr config = compile(QString(), nullptr);
+    return config;
+}
+
+VimConfigPtr VimConfig::compile(const QString &source, QStringList *errors)
+{
+    VimConfig *config = new VimConfig();
+    config->apply(m_default_source, nullptr);
+    config->apply(source, errors);
+    config->m_exclusions->finalize();
+    config->finalize();
+    return VimConfigPtr(config);
+}
+
+VimConfigPtr VimConfig::withOption(const QString &name, const QString &value,
+        QString *error) const
+{
+    VimConfig *config = new VimConfig(*this);
+    if (!config->setOption(name, value, error)) {
+        delete config;
+        return VimConfigPtr();
+    }
+    config->finalize();
+    return VimConfigPtr(config);
+}
+
+bool VimConfig::takesArgument(ActionType type)
+{
+    return SetMark == type || JumpToMark == type || RecordMacro == type
+        || ReplayMacro == type;
+}
+
+QString VimConfig::keyName(const QKeyEvent *event)
+{
+    const int key = event->key();
+
+    if ((event->modifiers() & Qt::ControlModifier)
+            && key >= Qt::Key_A && key <= Qt::Key_Z)
+        return QString("<C-%1>").arg(QChar('a' + key - Qt::Key_A));
+
+    if (Qt::Key_Escape == key)
+        return "<Esc>";
+
+    const QString text = event->text();
+    if (1 != text.size() || !text.at(0).isPrint())
+        return QString();
+
+    return text;
+}
+
+QStringList VimConfig::optionNames()
+{
+    QStringList names;
+    for (const VimOptionSpec &spec : vim_options)
+        names << spec.name;
+    for (const VimStringOptionSpec &spec : vim_string_options)
+        names << spec.name;
+    return names;
+}
+
+void VimConfig::apply(const QString &source, QStringList *errors)
+{
+    const QStringList lines = source.split('\n');
+    for (int line_i = 0; line_i < lines.size(); ++line_i) {
+        QString line = lines.at(line_i).trimmed();
+        if (line.isEmpty() || line.startsWith('"'))
+            continue;
+
+        /* Trailing comments, as in the README examples. As with the right
+         * hand side of a vim mapping, a mapped command runs to the end of
+         * the line, its quotes are its own.
+         */
+        QStringList args = line.split(' ', QString::SkipEmptyParts);
+        const bool maps_command = "map" == args.first() && args.size() >= 3
+            && args.at(2).startsWith(':');
+        const int comment_i = maps_command ? -1 : line.indexOf(" \"");
+        if (comment_i > 0) {
+            line = line.left(comment_i).trimmed();
+            args = line.split(' ', QString::SkipEmptyParts);
+        }
+
+        const QString statement = args.first();
+        QString error;
+
+        if ("set" == statement && 2 == args.size()) {
+            const QString assignment = args.at(1);
+            const int equal_i = assignment.indexOf('=');
+            if (equal_i < 0)
+                error = QString("missing value for %1").arg(assignment);
+            else
+                setOption(assignment.left(equal_i),
+                        assignment.mid(equal_i + 1), &error);
+        }
+        else if ("map" == statement && args.size() >= 3) {
+            /* Everything after the keys is the action, commands may have
+             * spaces.
+             */
+            const QString keys = args.at(1);
+            const QString target =
+                line.mid(line.indexOf(keys, statement.size()) + keys.size())
+                    .trimmed();
+            if (target.startsWith(':'))
+                m_keymap.insert(splitKeys(keys).join(QString()),
+                        {RunCommand, target.mid(1)});
+            else if (actionNames().contains(target))
+                m_keymap.insert(splitKeys(keys).join(QString()),
+                        {actionNames().value(target), QString()});
+            else
+                error = QString("unknown action %1").arg(target);
+        }
+        else if ("unmap" == statement && 2 == args.size()) {
+            if (!m_keymap.remove(splitKeys(args.at(1)).join(QString())))
+                error = QString("no such mapping %1").arg(args.at(1));
+        }
+        else if ("mapclear" == statement && 1 == args.size()) {
+            m_keymap.clear();
+        }
+        else if ("exclude" == statement
+                && (2 == args.size() || 3 == args.size())) {
+            if (!m_exclusions->addRule(args.at(1), args.value(2)))
+                error = QString("invalid pattern %1").arg(args.at(1));
+        }
+        else {
+            error = QString("invalid statement '%1'").arg(line);
+        }
+
+        if (!error.isEmpty() && errors)
+            errors->append(QString("line %1: %2").arg(line_i + 1).arg(error));
+    }
+}
+
+bool VimConfig::setOption(const QString &name, const QString &value,
+        QString *error)
+{
+    for (const VimOptionSpec &spec : vim_options) {
+        if (name != spec.name)
+            continue;
+
+        bool is_number = false;
+        const int number = value.toInt(&is_number);
+        if (!is_number || number < spec.min || number > spec.max) {
+            *error = QString("invalid value for %1: %2 (%3 to %4)")
+                .arg(name).arg(value).arg(spec.min).arg(spec.max);
+            return false;
+        }
+        m_options.insert(name, number);
+        return true;
+    }
+
+    for (const VimStringOptionSpec &spec : vim_string_options) {
+        if (name == spec.name) {
+            m_options.insert(name, value);
+            return true;
+        }
+    }
+
+    *error = QString("unknown option %1").arg(name);
+    return false;
+}
+
+void VimConfig::finalize()
+{
+    /* Every proper prefix of a mapping, on key boundaries, so the engine
+     * knows when to wait for more keys.
+     */
+    m_prefixes.clear();
+    for (auto it = m_keymap.constBegin(); it != m_keymap.constEnd(); ++it) {
+        const QStringList keys = splitKeys(it.key());
+        QString prefix;
+        for (int i = 0; i < keys.size() - 1; ++i) {
+            prefix += keys.at(i);
+            m_prefixes.insert(prefix);
+        }
+    }
+
+    m_single_step = m_options.value("scrollstep").toInt();
+    m_single_step_interval = m_options.value("scrollinterval").toInt();
+    m_num_scroll_steps = m_options.value("scrollsteps").toInt();
+}
+
+QStringList VimConfig::splitKeys(const QString &keys)
+{
+    QStringList res;
+    int i = 0;
+    while (i < keys.size()) {
+        const int close_i = keys.indexOf('>', i);
+        if ('<' == keys.at(i) && close_i > i + 1) {
+            /* Normalize "<c-O>" and friends to the names keyName gives. */
+            QString name = keys.mid(i + 1, close_i - i - 1);
+            if (name.size() == 3 && name.at(1) == '-'
+                    && name.at(0).toUpper() == 'C')
+                name = QString("C-%1").arg(name.at(2).toLower());
+            else if (0 == name.compare("esc", Qt::CaseInsensitive))
+                name = "Esc";
+            res << QString("<%1>").arg(name);
+            i = close_i + 1;
+        }
+        else {
+            res << keys.mid(i, 1);
+            ++i;
+        }
+    }
+    return res;
+}
@@ -0,0 +1,128 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimConfigLoader.h"
+
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtConcurrent>
+
+/* Editors tend to write a file in several steps (truncate, write, rename),
+ * changes are let to settle before compiling.
+ */
+const int VimConfigLoader::m_reload_delay = 200;
+
+VimConfigLoader::VimConfigLoader(QObject *parent)
+    : QObject(parent)
+    , m_file_path()
+    , m_fs_watcher()
+    , m_reload_timer()
+    , m_compile_watcher()
+    , m_config(VimConfig::defaults())
+    , m_errors()
+    , m_reload_pending(false)
+    , m_loaded(false)
+{
+    m_reload_timer.setSingleShot(true);
+    m_reload_timer.setInterval(m_reload_delay);
+    connect(&m_reload_timer, SIGNAL(timeout()), this, SLOT(reload()));
+
+    connect(&m_fs_watcher, SIGNAL(fileChanged(QString)),
+            this, SLOT(watchedPathChanged()));
+    connect(&m_fs_watcher, SIGNAL(directoryChanged(QString)),
+            this, SLOT(watchedPathChanged()));
+    connect(&m_compile_watcher, SIGNAL(finished()), this, SLOT(compiled()));
+}
+
+void VimConfigLoader::setFilePath(const QString &file_path)
+{
+    if (!m_fs_watcher.files().isEmpty())
+        m_fs_watcher.removePaths(m_fs_watcher.files());
+    if (!m_fs_watcher.directories().isEmpty())
+        m_fs_watcher.removePaths(m_fs_watcher.directories());
+
+    m_file_path = file_path;
+    updateWatchedPaths();
+    reload();
+}
+
+void VimConfigLoader::reload()
+{
+    if (m_compile_watcher.isRunning()) {
+        m_reload_pending = true;
+        return;
+    }
+
+    m_compile_watcher.setFuture(
+            QtConcurrent::run(&VimConfigLoader::load, m_file_path));
+}
+
+void VimConfigLoader::watchedPathChanged()
+{
+    /* A file replaced by rename is dropped from the watcher, and a newly
+     * created one is only seen through its directory.
+     */
+    updateWatchedPaths();
+    m_reload_timer.start();
+}
+
+void VimConfigLoader::compiled()
+{
+    const Result result = m_compile_watcher.result();
+    m_config = result.config;
+    m_errors = result.errors;
+    m_loaded = true;
+    emit configChanged();
+
+    if (m_reload_pending) {
+        m_reload_pending = false;
+        reload();
+    }
+}
+
+VimConfigLoader::Result VimConfigLoader::load(const QString &file_path)
+{
+    Result result;
+
+    QString source;
+    QFile file(file_path);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&file);
+        stream.setCodec("UTF-8");
+        source = stream.readAll();
+    }
+
+    result.config = VimConfig::compile(source, &result.errors);
+    return result;
+}
+
+void VimConfigLoader::updateWatchedPaths()
+{
+    if (m_file_path.isEmpty())
+        return;
+
+    const QFileInfo info(m_file_path);
+    if (!m_fs_watcher.directories().contains(info.absolutePath())
+            && info.dir().exists())
+        m_fs_watcher.addPath(info.absolutePath());
+    if (!m_fs_watcher.files().contains(info.absoluteFilePath())
+            && info.exists())
+        m_fs_watcher.addPath(info.absoluteFilePath());
+}
@@ -17,185 +17,801 @@
 * ============================================================ */
 
 #include "VimEngine.h"
+#include "VimCommandLine.h"
+#include "VimOutlinePicker.h"
+#include "VimPageHelper.h"
+#include "VimSearchResults.h"
+#include "VimTabPicker.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
 
 #include "webview.h"
 #include "browserwindow.h"
+#include "qzsettings.h"
+#include "settings.h"
 #include "tabbedwebview.h"
 #include "tabwidget.h"
+#include "webtab.h"
+
+/* Commands available in the ':' line, in the order they are documented. */
+static const QStringList vim_commands = QStringList()
+    << "tabnext" << "tabprevious" << "tabclose" << "tabonly"
+    << "tabrestore" << "tabopen" << "buffer" << "tabsearch" << "open"
+    << "back" << "forward" << "reload" << "top" << "bottom" << "scrollbind"
+    << "syncbind" << "scrollstats" << "discard" << "discardall" << "set"
+    << "sessionrecord" << "sessionstop";
 
-const int VimEngine::m_single_step = 9;
-const int VimEngine::m_single_step_interval = 15;
-const int VimEngine::m_num_scroll_steps = 7;
+/* Short names following vim's where one exists. Any other unambiguous
+ * prefix of a command is accepted too.
+ */
+static const QHash<QString, QString> vim_command_aliases = {
+    {"se", "set"},
+    {"scb", "scrollbind"},
+    {"tabn", "tabnext"},
+    {"tabp", "tabprevious"},
+    {"tabN", "tabprevious"},
+    {"tabc", "tabclose"},
+    {"tabo", "tabonly"},
+    {"tabnew", "tabopen"},
+    {"b", "buffer"},
+    {"o", "open"},
+    {"e", "open"},
+    {"q", "tabclose"}
+};
+
+const QString VimEngine::m_config_file_name("vimplugin.vimrc");
+const int VimEngine::m_max_count = 9999;
+const int VimEngine::m_max_replay_steps = 100000;
+/* Like vim's 'maxmapdepth', each level is a few frames of the UI thread. */
+const int VimEngine::m_max_replay_depth = 1000;
+/* One frame. */
+const int VimEngine::m_zoom_interval = 16;
+/* Even a feed that never ends is only followed this long. */
+const int VimEngine::m_max_follow_time = 60000;
+/* Longer than any keyboard's auto-repeat delay: a scroll key that sent
+ * nothing for this long is not held anymore, whether or not its release
+ * reached us.
+ */
+const int VimEngine::m_max_key_silence = 1000;
+/* Characters of a heading shown in the 'gO' outline. */
+const int VimEngine::m_max_outline_text = 120;
 
 VimEngine::VimEngine()
-    : m_g_pressed(false)
+    : m_started(false)
+    , m_settings_path()
+    , m_config(VimConfig::defaults())
+    , m_config_loader()
+    , m_pending_keys()
+    , m_pending_argument(VimConfig::NoAction)
+    , m_scroll_key(0)
     , m_scroll_active(false)
     , m_scroll_hor(0)
     , m_scroll_vert(0)
     , m_scroll_timer()
+    , m_scroll_bound()
+    , m_scroll_step_i(0)
+    , m_scroll_steps(0)
+    , m_scroll_quality()
+    , m_last_key_press()
     , m_page(nullptr)
+    , m_completer()
+    , m_command_line()
+    , m_tab_discarder()
+    , m_scroll_memory()
+    , m_marks()
+    , m_page_verdicts()
+    , m_paging_pages()
+    , m_macros()
+    , m_count(0)
+    , m_last_macro_register()
+    , m_replay_budget(0)
+    , m_replay_depth(0)
+    , m_batch()
+    , m_thumbnails()
+    , m_tab_picker()
+    , m_selection()
+    , m_zoom_page(nullptr)
+    , m_zoom_steps(0)
+    , m_zoom_reset(false)
+    , m_zoom_timer()
+    , m_text_index()
+    , m_search_results()
+    , m_search_text()
+    , m_find_view()
+    , m_follow_page(nullptr)
+    , m_follow_timer()
+    , m_follow_time()
+    , m_session_recorder()
+    , m_outline_picker()
 {
-    m_scroll_timer.setInterval(m_single_step_interval);
+    applyConfig();
     connect(&m_scroll_timer, SIGNAL(timeout()), this, SLOT(scroll()));
+    m_zoom_timer.setSingleShot(true);
+    m_zoom_timer.setInterval(m_zoom_interval);
+    connect(&m_zoom_timer, SIGNAL(timeout()), this, SLOT(applyZoom()));
+    m_follow_timer.setSingleShot(true);
+    connect(&m_follow_timer, SIGNAL(timeout()), this, SLOT(followBottom()));
+    connect(&m_config_loader, SIGNAL(configChanged()),
+            this, SLOT(configChanged()));
+
+    connect(&m_tab_discarder, SIGNAL(discarded(int, qint64)),
+            this, SLOT(reportDiscarded(int, qint64)));
+    connect(&m_selection, SIGNAL(yanked(int)),
+            this, SLOT(reportYanked(int)));
+    connect(&m_text_index, SIGNAL(searchFinished(QString, int)),
+            this, SLOT(reportSearch(QString, int)));
 }
 
 void VimEngine::handleKeyPressEvent(WebPage *page, QKeyEvent *event)
 {
+    start();
     m_page = page;
+    m_last_key_press.start();
+    m_session_recorder.recordKey(page, event);
+    connect(page, SIGNAL(scrollPositionChanged(QPointF)),
+            this, SLOT(pageScrolled()), Qt::UniqueConnection);
+    m_thumbnails.watch(tabWidget());
+    /* Any key takes over from a 'G' still following the bottom. */
+    stopFollowingBottom();
 
-    if ("h" == event->text()) {
-        startScroll(-1 * m_single_step, 0);
-        goto end;
+    /* Nothing animates a page that is not shown. */
+    TabWidget *tab_widget = tabWidget();
+    if (tab_widget) {
+        connect(tab_widget, SIGNAL(currentChanged(int)),
+                this, SLOT(stopAnimations()), Qt::UniqueConnection);
     }
 
-    if ("j" == event->text()) {
-        startScroll(0, m_single_step);
-        goto end;
-    }
-
-    if ("J" == event->text()) {
-        previousTab();
-        goto end;
-    }
+    /* Modifier presses, like the Shift typed before a global mark, have no
+     * name and must not break a pending sequence.
+     */
+    const QString key = VimConfig::keyName(event);
+    if (key.isEmpty())
+        return;
 
-    if ("k" == event->text()) {
-        startScroll(0, -1 * m_single_step);
-        goto end;
+    /* Caret and visual mode own the keyboard of their page until left. */
+    if (VimSelection::Off != m_selection.mode()) {
+        if (page == m_selection.page()) {
+            handleSelectionKey(key);
+            return;
+        }
+        m_selection.leave();
     }
 
-    if ("K" == event->text()) {
-        nextTab();
-        goto end;
-    }
+    /* Pass keys of a matching exclusion rule go to the page, unless they
+     * complete a sequence already started.
+     */
+    if (m_pending_keys.isEmpty()
+            && VimConfig::NoAction == m_pending_argument
+            && verdictFor(page).pass_keys.contains(key))
+        return;
 
-    if ("l" == event->text()) {
-        startScroll(m_single_step, 0);
-        goto end;
+    if (VimConfig::NoAction != m_pending_argument) {
+        const VimConfig::ActionType action = m_pending_argument;
+        const int count = takeCount();
+        m_pending_argument = VimConfig::NoAction;
+        if (VimConfig::RecordMacro != action)
+            m_macros.record({{action, QString()}, key, count});
+        runArgumentAction(action, key, count);
+        return;
     }
 
-    if ("G" == event->text()) {
-        m_page->runJavaScript(
-            QString("var page_height = document.body.scrollHeight;"
-                    "var page_y_offset = window.pageYOffset;"
-                    /* Adding 10 because of int truncation. */
-                    "((page_height - page_y_offset) / %1) + 10;")
-                .arg(m_num_scroll_steps),
-            [this] (const QVariant& res) {
-                this->startFullVerticalScroll(res.toInt());
-            });
-        goto end;
+    /* A count only comes before a sequence. "0" starts one only if it is
+     * not mapped, digits are always part of a count already started.
+     */
+    if (m_pending_keys.isEmpty() && 1 == key.size() && key.at(0).isDigit()
+            && (m_count > 0 || ("0" != key
+                    && VimConfig::NoAction == m_config->action(key).type))) {
+        m_count = qMin(m_count * 10 + key.toInt(), m_max_count);
+        return;
     }
 
-    if ("u" == event->text()) {
-        const QRect viewport_size = m_page->view()->geometry();
-        startScroll(0, -1 * (viewport_size.height() / 2) / m_num_scroll_steps);
-        goto end;
-    }
+    /* Any key ends a pending sequence, whether it completes it or not. */
+    const QString keys = m_pending_keys + key;
+    m_pending_keys.clear();
 
-    if ("d" == event->text()) {
-        const QRect viewport_size = m_page->view()->geometry();
-        startScroll(0, (viewport_size.height() / 2) / m_num_scroll_steps);
-        goto end;
+    VimConfig::Action action = m_config->action(keys);
+    if (VimConfig::NoAction == action.type && m_config->isPrefix(keys)) {
+        m_pending_keys = keys;
+        return;
     }
 
-    if ("g" == event->text()) {
-        if (!m_g_pressed) {
-            m_g_pressed = true;
+    /* A broken sequence like "gj" still runs its last key. */
+    if (VimConfig::NoAction == action.type && keys != key) {
+        action = m_config->action(key);
+        if (VimConfig::NoAction == action.type && m_config->isPrefix(key)) {
+            m_pending_keys = key;
             return;
         }
-        m_page->runJavaScript(
-            /* Adding 10 because of int truncation. */
-            QString("-1 * ((window.pageYOffset / %1) + 10)")
-                .arg(m_num_scroll_steps),
-            [this] (const QVariant& res) {
-                this->startFullVerticalScroll(res.toInt());
-            });
-        goto end;
     }
 
-    if ("r" == event->text()) {
-        m_page->view()->reload();
-        goto end;
+    /* 'q' ends a recording instead of starting one. */
+    if (VimConfig::RecordMacro == action.type && m_macros.isRecording()) {
+        takeCount();
+        m_macros.stopRecording();
+        return;
     }
 
-    if ("x" == event->text()) {
-        closeCurTab();
-        goto end;
+    if (VimConfig::takesArgument(action.type)) {
+        m_pending_argument = action.type;
+        return;
     }
 
-    if ("X" == event->text()) {
-        openLastClosedTab();
-        goto end;
+    const int count = takeCount();
+    /* What is typed in the command line is recorded as the command it
+     * runs, see 'runCommandLine'.
+     */
+    if (VimConfig::EnterCommandLine != action.type
+            && VimConfig::NoAction != action.type)
+        m_macros.record({action, QString(), count});
+    runAction(action, event, count);
+}
+
+void VimEngine::runAction(const VimConfig::Action &action, QKeyEvent *event,
+        int count)
+{
+    const int step = m_config->singleStep();
+    const int num_steps = m_config->numScrollSteps();
+
+    /* Scrolls, zooms and structural motions take the count as a distance,
+     * anything else is repeated as a batch so "5K" switches tabs once.
+     */
+    if (count > 1 && !isScrollAction(action.type)
+            && !isZoomAction(action.type) && !isOutlineMotion(action.type)) {
+        const bool outermost = !m_batch.active;
+        if (outermost)
+            beginBatch();
+        for (int i = 0; i < count; ++i)
+            runAction(action, event, 1);
+        if (outermost)
+            endBatch();
+        return;
     }
 
-end:
-    m_g_pressed = false;
-    return;
+    if (m_batch.active && !isScrollAction(action.type)
+            && !isZoomAction(action.type)
+            && VimConfig::NextTab != action.type
+            && VimConfig::PreviousTab != action.type)
+        flushBatch();
+
+    switch (action.type) {
+        case VimConfig::ScrollLeft:
+            scrollSteps(-1 * step, 0, count, event);
+            break;
+
+        case VimConfig::ScrollDown:
+            scrollSteps(0, step, count, event);
+            break;
+
+        case VimConfig::ScrollUp:
+            scrollSteps(0, -1 * step, count, event);
+            break;
+
+        case VimConfig::ScrollRight:
+            scrollSteps(step, 0, count, event);
+            break;
+
+        case VimConfig::ScrollHalfPageDown: {
+            const QRect viewport_size = m_page->view()->geometry();
+            scrollSteps(0, (viewport_size.height() / 2) / num_steps, count,
+                    event);
+            break;
+        }
+
+        case VimConfig::ScrollHalfPageUp: {
+            const QRect viewport_size = m_page->view()->geometry();
+            scrollSteps(0, -1 * (viewport_size.height() / 2) / num_steps,
+                    count, event);
+            break;
+        }
+
+        case VimConfig::ScrollToTop:
+            scrollToTop();
+            break;
+
+        case VimConfig::ScrollToBottom:
+            scrollToBottom();
+            break;
+
+        case VimConfig::Reload:
+            m_page->view()->reload();
+            break;
+
+        case VimConfig::NextTab:
+            nextTab();
+            break;
+
+        case VimConfig::PreviousTab:
+            previousTab();
+            break;
+
+        case VimConfig::RemoveTab:
+            closeCurTab();
+            break;
+
+        case VimConfig::RestoreTab:
+            openLastClosedTab();
+            break;
+
+        case VimConfig::EnterCommandLine:
+            openCommandLine();
+            break;
+
+        case VimConfig::TabPicker:
+            openTabPicker();
+            break;
+
+        case VimConfig::ZoomIn:
+            zoom(count, false);
+            break;
+
+        case VimConfig::ZoomOut:
+            zoom(-1 * count, false);
+            break;
+
+        case VimConfig::ZoomReset:
+            zoom(0, true);
+            break;
+
+        case VimConfig::NextHeading:
+            jumpToOutline("heading", count);
+            break;
+
+        case VimConfig::PreviousHeading:
+            jumpToOutline("heading", -1 * count);
+            break;
+
+        case VimConfig::NextLandmark:
+            jumpToOutline("landmark", count);
+            break;
+
+        case VimConfig::PreviousLandmark:
+            jumpToOutline("landmark", -1 * count);
+            break;
+
+        case VimConfig::NextParagraph:
+            jumpToOutline("paragraph", count);
+            break;
+
+        case VimConfig::PreviousParagraph:
+            jumpToOutline("paragraph", -1 * count);
+            break;
+
+        case VimConfig::Outline:
+            openOutline();
+            break;
+
+        case VimConfig::CaretMode:
+            m_selection.enter(m_page, VimSelection::Caret);
+            break;
+
+        case VimConfig::VisualMode:
+            m_selection.enter(m_page, VimSelection::Visual);
+            break;
+
+        case VimConfig::RunCommand:
+            executeCommand(action.command);
+            break;
+
+        case VimConfig::JumpOlder:
+            jumpOlder();
+            break;
+
+        case VimConfig::JumpNewer:
+            jumpNewer();
+            break;
+
+        case VimConfig::NextPage:
+            followPageLink("next");
+            break;
+
+        case VimConfig::PreviousPage:
+            followPageLink("prev");
+            break;
+
+        default:
+            break;
+    }
 }
 
-void VimEngine::handleKeyReleaseEvent(WebPage *page, QKeyEvent *event)
+void VimEngine::runArgumentAction(VimConfig::ActionType action,
+        const QString &key, int count)
 {
-    Q_UNUSED(page);
+    /* Marks and registers take any key, an invalid name is swallowed like
+     * vim does instead of running as a command.
+     */
+    if (1 != key.size())
+        return;
 
-    if (Qt::Key_H == event->key()) {
-        m_scroll_active = false;
+    if (VimConfig::RecordMacro == action) {
+        if (m_macros.startRecording(key.at(0)))
+            showMessage(QString("recording @%1").arg(key.toLower()));
         return;
     }
 
-    if (Qt::Key_J == event->key()) {
-        m_scroll_active = false;
+    if (VimConfig::ReplayMacro == action) {
+        replayMacro(key.at(0), count);
         return;
     }
 
-    if (Qt::Key_K == event->key()) {
-        m_scroll_active = false;
+    if (m_batch.active)
+        flushBatch();
+
+    if (VimConfig::SetMark == action) {
+        if (!m_marks.setMark(key.at(0), currentPosition()))
+            showMessage("E191: Argument must be a letter or forward/backward quote");
         return;
     }
 
-    if (Qt::Key_L == event->key()) {
-        m_scroll_active = false;
+    if (VimConfig::JumpToMark != action)
+        return;
+
+    VimMarks::Position target;
+    if ("`" == key || "'" == key) {
+        if (m_marks.previousContext(currentPosition(), &target))
+            jumpTo(target);
         return;
     }
 
-    if (Qt::Key_U == event->key()) {
-        m_scroll_active = false;
+    if (!m_marks.mark(key.at(0), m_page->url(), &target)) {
+        showMessage("E20: Mark not set");
         return;
     }
+    recordJump();
+    jumpTo(target);
+}
+
+void VimEngine::handleKeyReleaseEvent(WebPage *page, QKeyEvent *event)
+{
+    m_session_recorder.recordKey(page, event);
 
-    if (Qt::Key_D == event->key()) {
+    /* Releasing the key that started a scroll ends it after the current
+     * steps, whatever modifiers are held by then.
+     */
+    if (m_scroll_key == event->key())
         m_scroll_active = false;
+}
+
+void VimEngine::handleNavigationRequest(WebPage *page, const QUrl &url,
+        QWebEnginePage::NavigationType type, bool is_main_frame)
+{
+    if (!page || !is_main_frame)
         return;
+
+    m_text_index.watchPage(page);
+
+    /* Whatever the navigation is, the page being left is remembered. Only
+     * going back to a known entry brings the position back though: a link
+     * to an already visited URL should start at the top as usual.
+     */
+    m_scroll_memory.remember(page->url(), page->scrollPosition());
+
+    /* Prefetching is for the document being paged through. Loads other
+     * than the one ']]' started, and redirects of it to another site, end
+     * it: they are not asked for what their next page is.
+     */
+    auto paging = m_paging_pages.find(page);
+    if (paging != m_paging_pages.end()
+            && (paging->target.isEmpty()
+                || url.host() != paging->target.host()))
+        m_paging_pages.erase(paging);
+
+    if (QWebEnginePage::NavigationTypeReload == type
+            || QWebEnginePage::NavigationTypeBackForward == type)
+        m_scroll_memory.restoreWhenReady(page, url);
+    else
+        m_scroll_memory.cancelRestoreUnlessFor(page, url);
+}
+
+bool VimEngine::isExcluded(WebPage *page)
+{
+    start();
+    /* Keys typed before the user's rules are compiled go to the page
+     * untouched: running them against the defaults could act on a page
+     * that is excluded, and no verdict is cached from them.
+     */
+    if (!m_config_loader.isLoaded())
+        return true;
+    return verdictFor(page).disabled;
+}
+
+void VimEngine::forgetPage(WebPage *deleted_page)
+{
+    m_page_verdicts.remove(deleted_page);
+    m_paging_pages.remove(deleted_page);
+    m_selection.forgetPage(deleted_page);
+    m_scroll_bound.remove(deleted_page);
+    m_scroll_quality.remove(deleted_page);
+    if (deleted_page == m_zoom_page) {
+        m_zoom_timer.stop();
+        m_zoom_page = nullptr;
     }
 }
 
+void VimEngine::runCommandLine(const QString &command_line)
+{
+    m_macros.record({{VimConfig::RunCommand, command_line}, QString(), 1});
+    executeCommand(command_line);
+}
+
 void VimEngine::stopScrollingIfPageWasDeleted(WebPage *deleted_page)
 {
     if (m_page == deleted_page) {
         stopScroll();
         m_page = nullptr;
     }
+    if (m_follow_page == deleted_page) {
+        m_follow_timer.stop();
+        m_follow_page = nullptr;
+    }
+}
+
+bool VimEngine::executeCommand(const QString &command_line)
+{
+    const QString trimmed = command_line.trimmed();
+    const int space_i = trimmed.indexOf(' ');
+    const QString name = resolveCommand(trimmed.left(space_i));
+    const QString arg = space_i < 0 ? QString()
+                                    : trimmed.mid(space_i + 1).trimmed();
+
+    if (name.isEmpty()) {
+        showMessage(QString("E492: Not an editor command: %1").arg(trimmed));
+        return false;
+    }
+
+    if (!m_page)
+        return false;
+
+    if ("tabnext" == name) {
+        nextTab();
+        return true;
+    }
+
+    if ("tabprevious" == name) {
+        previousTab();
+        return true;
+    }
+
+    if ("tabclose" == name) {
+        closeCurTab();
+        return true;
+    }
+
+    if ("tabonly" == name) {
+        TabWidget *tab_widget = tabWidget();
+        if (tab_widget)
+            tab_widget->closeAllButCurrent(tab_widget->currentIndex());
+        return true;
+    }
+
+    if ("tabrestore" == name) {
+        openLastClosedTab();
+        return true;
+    }
+
+    if ("tabopen" == name) {
+        TabWidget *tab_widget = tabWidget();
+        if (tab_widget) {
+            tab_widget->addView(QUrl::fromUserInput(arg),
+                    Qz::NT_SelectedTabAtTheEnd);
+        }
+        return true;
+    }
+
+    if ("buffer" == name) {
+        switchToBuffer(arg);
+        return true;
+    }
+
+    if ("discard" == name) {
+        bool is_number = false;
+        const int count = arg.isEmpty() ? 1 : arg.toInt(&is_number);
+        if (!arg.isEmpty() && (!is_number || count <= 0)) {
+            showMessage(QString("E488: Trailing characters: %1").arg(arg));
+            return false;
+        }
+        if (!m_tab_discarder.discard(tabWidget(), count))
+            showMessage("No background tab to discard");
+        return true;
+    }
+
+    if ("discardall" == name) {
+        TabWidget *tab_widget = tabWidget();
+        if (!tab_widget || !m_tab_discarder.discard(tab_widget,
+                    tab_widget->count()))
+            showMessage("No background tab to discard");
+        return true;
+    }
+
+    if ("tabsearch" == name) {
+        if (arg.isEmpty()) {
+            showMessage("E35: No search text");
+            return false;
+        }
+        searchTabs(arg);
+        return true;
+    }
+
+    if ("sessionrecord" == name) {
+        if (arg.isEmpty()) {
+            showMessage("E32: No file name");
+            return false;
+        }
+        QString error;
+        if (!m_session_recorder.start(arg, tabWidget(), &error)) {
+            showMessage(QString("E212: Can't open file for writing: %1: %2")
+                    .arg(arg, error));
+            return false;
+        }
+        showMessage(QString("recording session to %1").arg(arg));
+        return true;
+    }
+
+    if ("sessionstop" == name) {
+        if (!m_session_recorder.isRecording()) {
+            showMessage("Not recording a session");
+            return false;
+        }
+        showMessage(QString("%1 session events recorded")
+                .arg(m_session_recorder.stop()));
+        return true;
+    }
+
+    if ("open" == name) {
+        if (arg.isEmpty()) {
+            showMessage("E32: No URL given");
+            return false;
+        }
+        m_page->view()->load(QUrl::fromUserInput(arg));
+        return true;
+    }
+
+    if ("back" == name) {
+        m_page->view()->back();
+        return true;
+    }
+
+    if ("forward" == name) {
+        m_page->view()->forward();
+        return true;
+    }
+
+    if ("reload" == name) {
+        m_page->view()->reload();
+        return true;
+    }
+
+    if ("top" == name) {
+        scrollToTop();
+        return true;
+    }
+
+    if ("bottom" == name) {
+        scrollToBottom();
+        return true;
+    }
+
+    if ("scrollbind" == name) {
+        toggleScrollBind();
+        return true;
+    }
+
+    if ("syncbind" == name) {
+        if (!m_scroll_bound.contains(m_page)) {
+            showMessage("Page is not scroll bound");
+            return false;
+        }
+        syncBoundPages(true, true);
+        return true;
+    }
+
+    if ("scrollstats" == name) {
+        showMessage(m_scroll_quality.value(m_page).summary());
+        return true;
+    }
+
+    if ("set" == name) {
+        setOption(arg);
+        return true;
+    }
+
+    return false;
 }
 
 void VimEngine::scroll()
 {
-    static int step_i = 0;
-    m_page->scroll(m_scroll_hor, m_scroll_vert);
-    ++step_i;
-    if (step_i >= m_num_scroll_steps) {
-        step_i = 0;
+    /* The quality is picked per cycle: fewer steps cover the same
+     * distance in the same time, so a held key scrolls as fast as ever.
+     */
+    const int full_steps = m_config->numScrollSteps();
+    if (0 == m_scroll_step_i) {
+        m_scroll_steps = m_config->option("adaptivescroll").toInt()
+            ? m_scroll_quality.value(m_page).steps(full_steps) : full_steps;
+        m_scroll_timer.setInterval(m_config->singleStepInterval()
+                * full_steps / m_scroll_steps);
+    }
+    const int step_hor = m_scroll_hor * full_steps / m_scroll_steps;
+    const int step_vert = m_scroll_vert * full_steps / m_scroll_steps;
+
+    /* The helper scrolls whatever element the user is looking at, which is
+     * not always the document.
+     */
+    VimPageHelper::run(m_page, QString("scrollBy(%1, %2)")
+            .arg(step_hor).arg(step_vert));
+    m_scroll_quality[m_page].stepRequested();
+    syncBoundPages(0 != m_scroll_hor, 0 != m_scroll_vert);
+    ++m_scroll_step_i;
+    if (m_scroll_step_i >= m_scroll_steps) {
+        m_scroll_step_i = 0;
+        /* A held key keeps sending presses. One silent for too long was
+         * released somewhere we did not see, like another window.
+         */
+        if (m_scroll_active
+                && m_last_key_press.elapsed() > m_max_key_silence)
+            m_scroll_active = false;
+
         /* If the user is still pressing the key we don't stop scrolling. */
         if (!m_scroll_active)
             stopScroll();
     }
 }
 
+void VimEngine::configChanged()
+{
+    m_config = m_config_loader.config();
+    /* Verdicts are recomputed lazily against the new rules. */
+    m_page_verdicts.clear();
+    applyConfig();
+
+    if (!m_config_loader.errors().isEmpty()) {
+        showMessage(QString("%1: %2").arg(m_config_loader.filePath())
+                .arg(m_config_loader.errors().first()));
+    }
+}
+
+void VimEngine::pageUrlChanged()
+{
+    WebPage *page = static_cast<WebPage *>(sender());
+    m_page_verdicts.insert(page, m_config->exclusion(page->url()));
+}
+
+void VimEngine::prefetchPageLink(bool ok)
+{
+    WebPage *page = static_cast<WebPage *>(sender());
+    auto paging = m_paging_pages.find(page);
+    if (paging == m_paging_pages.end())
+        return;
+
+    /* The next load of this page is the user's, unless ']]' starts it. */
+    paging->target.clear();
+    if (!ok || !m_config->option("prefetch").toInt())
+        return;
+
+    VimPageHelper::run(page, QString("prefetchPageLink(%1)")
+            .arg(pageLinkArguments(paging->rel)));
+}
+
+void VimEngine::reportDiscarded(int count, qint64 reclaimed_kb)
+{
+    QString message = QString("%1 tab(s) discarded").arg(count);
+    if (reclaimed_kb >= 0)
+        message += QString(", %1 MB reclaimed").arg(reclaimed_kb / 1024.0, 0,
+                'f', 1);
+    showMessage(message);
+}
+
 void VimEngine::startScroll(int scroll_hor, int scroll_vert)
 {
+    /* The user moving on their own wins over a pending restore. */
+    m_scroll_memory.cancelRestore(m_page);
+
     m_scroll_hor = scroll_hor;
     m_scroll_vert = scroll_vert;
     if (!m_scroll_active) {
         m_scroll_active = true;
-        m_scroll_timer.start();
+        startScrollTimer();
     }
 }
 
@@ -204,20 +820,88 @@ void VimEngine::stopScroll()
     m_scroll_hor = 0;
     m_scroll_vert = 0;
     m_scroll_active = false;
+    m_scroll_step_i = 0;
     m_scroll_timer.stop();
 }
 
+void VimEngine::pageScrolled()
+{
+    /* Only pages the engine scrolled have a state to update. */
+    auto it = m_scroll_quality.find(static_cast<WebPage *>(sender()));
+    if (it != m_scroll_quality.end()
+            && m_config->option("adaptivescroll").toInt())
+        it->positionChanged(m_config->singleStepInterval());
+}
+
+void VimEngine::toggleScrollBind()
+{
+    if (m_scroll_bound.remove(m_page)) {
+        showMessage(QString("noscrollbind (%1 page(s) still bound)")
+                .arg(m_scroll_bound.size()));
+        return;
+    }
+
+    m_scroll_bound.insert(m_page);
+    showMessage(QString("scrollbind (%1 page(s) bound)")
+            .arg(m_scroll_bound.size()));
+}
+
+/* One animator drives every bound page: each step of the page scrolled is
+ * followed by reading where it got to, and the others are set to the same
+ * fraction of their own scroll range. Setting positions instead of
+ * stepping each page along keeps pages of different lengths from drifting
+ * apart, whatever steps get clamped or dropped.
+ */
+void VimEngine::syncBoundPages(bool hor, bool vert)
+{
+    if (m_scroll_bound.size() < 2 || !m_scroll_bound.contains(m_page))
+        return;
+
+    WebPage *leader = m_page;
+    VimPageHelper::run(leader, "scrollRatio()",
+        [this, leader, hor, vert] (const QVariant& res) {
+            const QVariantList ratio = res.toList();
+            if (2 != ratio.size() || !m_scroll_bound.contains(leader))
+                return;
+
+            const QString call = QString("scrollToRatio(%1, %2)")
+                .arg(hor ? ratio.at(0).toDouble() : -1.0)
+                .arg(vert ? ratio.at(1).toDouble() : -1.0);
+            foreach (WebPage *page, m_scroll_bound) {
+                if (page != leader)
+                    VimPageHelper::run(page, call);
+            }
+        });
+}
+
 void VimEngine::startFullVerticalScroll(int scroll_step_size)
 {
     stopScroll();
+    m_scroll_memory.cancelRestore(m_page);
 
     m_scroll_hor = 0;
     m_scroll_vert = scroll_step_size;
+    startScrollTimer();
+}
+
+void VimEngine::startScrollTimer()
+{
     m_scroll_timer.start();
+    /* Reduced and instant scrolls take their first step right away, they
+     * are there to get the page moving sooner.
+     */
+    if (VimScrollQuality::Smooth != m_scroll_quality.value(m_page).mode())
+        scroll();
 }
 
 void VimEngine::nextTab()
 {
+    if (m_batch.active) {
+        flushBatchScroll();
+        ++m_batch.tab_offset;
+        return;
+    }
+
     TabbedWebView *tab_view = dynamic_cast<TabbedWebView*>(m_page->view());
     if (!tab_view || !tab_view->browserWindow())
         return;
@@ -227,6 +911,12 @@ void VimEngine::nextTab()
 
 void VimEngine::previousTab()
 {
+    if (m_batch.active) {
+        flushBatchScroll();
+        --m_batch.tab_offset;
+        return;
+    }
+
     TabbedWebView *tab_view = dynamic_cast<TabbedWebView*>(m_page->view());
     if (!tab_view || !tab_view->browserWindow())
         return;
@@ -249,3 +939,768 @@ void VimEngine::openLastClosedTab()
                 m_page->view())->browserWindow()->tabWidget();
     tab_widget->restoreClosedTab();
 }
+
+void VimEngine::openCommandLine()
+{
+    if (!prepareCommandLine())
+        return;
+
+    m_completer.refresh(tabWidget());
+    m_command_line->open();
+}
+
+bool VimEngine::prepareCommandLine()
+{
+    if (!m_page || !m_page->view())
+        return false;
+
+    /* The line lives inside the view of the current page, so it is rebuilt
+     * when the user moves on to another tab. The old one may be the line
+     * whose command is running, it goes once that returned.
+     */
+    if (!m_command_line || m_command_line->parentWidget() != m_page->view()) {
+        if (m_command_line) {
+            m_command_line->hide();
+            m_command_line->deleteLater();
+        }
+        m_command_line = new VimCommandLine(&m_completer, m_page->view());
+
+        const QList<VimCompleter::Source> tabs = {VimCompleter::Tabs};
+        const QList<VimCompleter::Source> pages = {VimCompleter::Bookmarks,
+                                                   VimCompleter::History};
+        m_command_line->setArgumentSources("buffer", tabs);
+        m_command_line->setArgumentSources("b", tabs);
+        m_command_line->setArgumentSources("open", pages);
+        m_command_line->setArgumentSources("o", pages);
+        m_command_line->setArgumentSources("e", pages);
+        m_command_line->setArgumentSources("tabopen", pages);
+        m_command_line->setArgumentSources("tabnew", pages);
+
+        connect(m_command_line, SIGNAL(commandEntered(QString)),
+                this, SLOT(runCommandLine(QString)));
+    }
+    return true;
+}
+
+void VimEngine::openTabPicker()
+{
+    TabWidget *tab_widget = tabWidget();
+    if (!tab_widget)
+        return;
+
+    /* The current tab is shown as it is now, its preview replaces the old
+     * one as soon as it is encoded.
+     */
+    m_thumbnails.capture(tab_widget->webTab());
+
+    delete m_tab_picker;
+    m_tab_picker = new VimTabPicker(tab_widget, &m_thumbnails, m_page->view());
+    connect(m_tab_picker, SIGNAL(tabSelected(int)),
+            this, SLOT(pickTab(int)));
+    m_tab_picker->open();
+}
+
+void VimEngine::handleSelectionKey(const QString &key)
+{
+    /* Counts as in normal mode, but a "0" of its own is a motion. */
+    if (1 == key.size() && key.at(0).isDigit() && (m_count > 0 || "0" != key)) {
+        m_count = qMin(m_count * 10 + key.toInt(), m_max_count);
+        return;
+    }
+
+    const int count = takeCount();
+    if (1 == key.size() && m_selection.move(key.at(0), count))
+        return;
+
+    if ("y" == key)
+        m_selection.yank();
+    else if ("v" == key && VimSelection::Visual == m_selection.mode())
+        m_selection.leave();
+    else if ("v" == key)
+        m_selection.enter(m_page, VimSelection::Visual);
+    else if ("c" == key)
+        m_selection.enter(m_page, VimSelection::Caret);
+    else if ("<Esc>" == key)
+        m_selection.leave();
+}
+
+void VimEngine::zoom(int steps, bool reset)
+{
+    /* Each zoom change relayouts the whole page: changes made within a
+     * frame, like a count or a held key, are applied as one.
+     */
+    if (m_zoom_page && m_zoom_page != m_page)
+        applyZoom();
+
+    m_zoom_page = m_page;
+    if (reset) {
+        /* Steps before a reset no longer matter. */
+        m_zoom_reset = true;
+        m_zoom_steps = 0;
+    }
+    m_zoom_steps = qBound(-1 * m_max_count, m_zoom_steps + steps, m_max_count);
+
+    if (!m_zoom_timer.isActive())
+        m_zoom_timer.start();
+}
+
+void VimEngine::applyZoom()
+{
+    m_zoom_timer.stop();
+    WebPage *page = m_zoom_page;
+    const int steps = m_zoom_steps;
+    const bool reset = m_zoom_reset;
+    m_zoom_page = nullptr;
+    m_zoom_steps = 0;
+    m_zoom_reset = false;
+
+    if (!page || !page->view())
+        return;
+
+    WebView *view = page->view();
+    const int base = reset ? qzSettings->defaultZoomLevel : view->zoomLevel();
+    const int level = qBound(0, base + steps, WebView::zoomLevels().size() - 1);
+    if (level != view->zoomLevel())
+        view->setZoomLevel(level);
+    showMessage(QString("zoom %1%").arg(WebView::zoomLevels().at(level)));
+}
+
+void VimEngine::searchTabs(const QString &text)
+{
+    delete m_search_results;
+    m_search_text = text;
+    m_search_results = new VimSearchResults(m_page->view());
+    connect(&m_text_index,
+            SIGNAL(found(WebTab*, QString, QString, int)),
+            m_search_results,
+            SLOT(addMatch(WebTab*, QString, QString, int)));
+    connect(m_search_results, SIGNAL(matchSelected(WebTab*)),
+            this, SLOT(jumpToMatch(WebTab*)));
+    m_search_results->open();
+    m_text_index.search(text);
+}
+
+void VimEngine::reportSearch(const QString &text, int matches)
+{
+    if (matches > 0) {
+        showMessage(QString("%1 tab(s) match \"%2\"").arg(matches).arg(text));
+        return;
+    }
+
+    if (m_search_results)
+        m_search_results->leave();
+    showMessage(QString("E486: Pattern not found: %1").arg(text));
+}
+
+void VimEngine::jumpToMatch(WebTab *tab)
+{
+    TabbedWebView *view = tab->webView();
+    BrowserWindow *window = view ? view->browserWindow() : nullptr;
+    if (!window)
+        return;
+
+    /* A discarded tab is loaded again on activation, its text can only be
+     * found once that is done.
+     */
+    const bool loading = m_tab_discarder.isDiscarded(tab) || tab->isLoading();
+    /* Like any find, the jump can be undone with '' or Ctrl-O. */
+    if (m_page)
+        recordJump();
+    window->tabWidget()->setCurrentIndex(tab->tabIndex());
+    window->activateWindow();
+
+    if (!loading) {
+        view->findText(m_search_text);
+        return;
+    }
+    m_find_view = view;
+    connect(view, SIGNAL(loadFinished(bool)),
+            this, SLOT(findPendingText()), Qt::UniqueConnection);
+}
+
+void VimEngine::findPendingText()
+{
+    WebView *view = qobject_cast<WebView *>(sender());
+    if (view)
+        disconnect(view, SIGNAL(loadFinished(bool)),
+                this, SLOT(findPendingText()));
+    if (view && view == m_find_view)
+        view->findText(m_search_text);
+    m_find_view = nullptr;
+}
+
+void VimEngine::reportYanked(int length)
+{
+    showMessage(length > 0 ? QString("%1 characters yanked").arg(length)
+                           : QString("Nothing to yank"));
+}
+
+void VimEngine::pickTab(int index)
+{
+    TabWidget *tab_widget = tabWidget();
+    if (tab_widget)
+        tab_widget->setCurrentIndex(index);
+}
+
+void VimEngine::showMessage(const QString &message)
+{
+    /* Messages show in the current page's view, whether or not a command
+     * line was ever opened there.
+     */
+    if (prepareCommandLine())
+        m_command_line->showMessage(message);
+}
+
+TabWidget* VimEngine::tabWidget() const
+{
+    if (!m_page)
+        return nullptr;
+
+    TabbedWebView *tab_view = dynamic_cast<TabbedWebView*>(m_page->view());
+    if (!tab_view || !tab_view->browserWindow())
+        return nullptr;
+
+    return tab_view->browserWindow()->tabWidget();
+}
+
+QString VimEngine::resolveCommand(const QString &name) const
+{
+    if (name.isEmpty())
+        return QString();
+
+    if (vim_commands.contains(name))
+        return name;
+
+    if (vim_command_aliases.contains(name))
+        return vim_command_aliases.value(name);
+
+    const QVector<VimPrefixIndex::Item> matches =
+        m_completer.complete(VimCompleter::Commands, name, 2);
+    if (1 == matches.size())
+        return matches.first().value;
+
+    return QString();
+}
+
+void VimEngine::switchToBuffer(const QString &buffer)
+{
+    TabWidget *tab_widget = tabWidget();
+    if (!tab_widget)
+        return;
+
+    /* Completed buffers look like "<number>: <title>". */
+    bool is_number = false;
+    const int number = buffer.section(':', 0, 0).trimmed().toInt(&is_number);
+    if (is_number) {
+        if (number < 1 || number > tab_widget->count()) {
+            showMessage(QString("E86: Buffer %1 does not exist").arg(number));
+            return;
+        }
+        tab_widget->setCurrentIndex(number - 1);
+        return;
+    }
+
+    const QVector<VimPrefixIndex::Item> matches =
+        m_completer.complete(VimCompleter::Tabs, buffer, 1);
+    if (matches.isEmpty()) {
+        showMessage(QString("E94: No matching buffer for %1").arg(buffer));
+        return;
+    }
+    tab_widget->setCurrentIndex(matches.first().value.toInt());
+}
+
+void VimEngine::setSettingsPath(const QString &settings_path)
+{
+    m_settings_path = settings_path;
+    m_marks.setSettingsPath(settings_path);
+
+    /* Exclusion rules decide whether the very first key is ours, so the
+     * config is compiled right away. It happens in a worker thread.
+     */
+    m_config_loader.setFilePath(
+            QDir(m_settings_path).filePath(m_config_file_name));
+}
+
+void VimEngine::start()
+{
+    /* Nothing but key handlers and the config is set up when the browser
+     * starts. The command index, the page helper and the text index wait
+     * for the first key, so a browser that is never typed into pays little.
+     */
+    if (m_started)
+        return;
+    m_started = true;
+
+    m_completer.setCommands(vim_commands);
+    VimPageHelper::install();
+    m_text_index.start();
+
+    /* Releases of keys held while focus moves away never reach us. */
+    connect(qApp, SIGNAL(applicationStateChanged(Qt::ApplicationState)),
+            this, SLOT(applicationStateChanged(Qt::ApplicationState)));
+    connect(qApp, SIGNAL(focusWindowChanged(QWindow*)),
+            this, SLOT(focusWindowChanged(QWindow*)));
+}
+
+void VimEngine::setOption(const QString &assignment)
+{
+    if (assignment.isEmpty()) {
+        QStringList values;
+        foreach (const QString &name, VimConfig::optionNames()) {
+            values << QString("%1=%2").arg(name)
+                .arg(m_config->option(name).toString());
+        }
+        showMessage(values.join("  "));
+        return;
+    }
+
+    const int equal_i = assignment.indexOf('=');
+    if (equal_i < 0) {
+        QString name = assignment;
+        if (name.endsWith('?'))
+            name.chop(1);
+        if (!m_config->option(name).isValid()) {
+            showMessage(QString("E518: Unknown option: %1").arg(name));
+            return;
+        }
+        showMessage(QString("%1=%2").arg(name)
+                .arg(m_config->option(name).toString()));
+        return;
+    }
+
+    /* A ':set' lasts until the config file changes, like sourcing a vimrc
+     * again in vim.
+     */
+    QString error;
+    const VimConfigPtr config = m_config->withOption(
+            assignment.left(equal_i), assignment.mid(equal_i + 1), &error);
+    if (!config) {
+        showMessage(QString("E474: %1").arg(error));
+        return;
+    }
+    m_config = config;
+    applyConfig();
+}
+
+void VimEngine::applyConfig()
+{
+    m_scroll_timer.setInterval(m_config->singleStepInterval());
+    m_thumbnails.setBudget(m_config->option("thumbnailbudget").toInt() * 1024);
+    if (!m_config->option("adaptivescroll").toInt())
+        m_scroll_quality.clear();
+}
+
+void VimEngine::scrollToTop()
+{
+    if (m_batch.active) {
+        flushBatch();
+        recordJump();
+        m_batch.scroll_edge = -1;
+        return;
+    }
+
+    recordJump();
+    VimPageHelper::run(m_page, "scrollTop()",
+        [this] (const QVariant& res) {
+            /* Adding 10 because of int truncation. */
+            this->startFullVerticalScroll(
+                -1 * ((res.toInt() / m_config->numScrollSteps()) + 10));
+        });
+}
+
+void VimEngine::scrollToBottom()
+{
+    if (m_batch.active) {
+        flushBatch();
+        recordJump();
+        m_batch.scroll_edge = 1;
+        return;
+    }
+
+    recordJump();
+    if (m_config->option("followbottom").toInt() > 0) {
+        m_follow_page = m_page;
+        m_follow_time.start();
+        VimPageHelper::run(m_page, QString("startFollowing(%1, %2)")
+                .arg(m_config->singleStep() * m_config->numScrollSteps())
+                .arg(m_config->numScrollSteps()));
+        m_follow_timer.start(m_config->option("followbottom").toInt());
+    }
+    VimPageHelper::run(m_page, "distanceToBottom()",
+        [this] (const QVariant& res) {
+            /* Adding 10 because of int truncation. */
+            this->startFullVerticalScroll(
+                (res.toInt() / m_config->numScrollSteps()) + 10);
+        });
+}
+
+void VimEngine::followBottom()
+{
+    if (!m_follow_page)
+        return;
+
+    if (m_follow_time.elapsed() > m_max_follow_time) {
+        stopFollowingBottom();
+        return;
+    }
+
+    /* The page chases its own bottom as the content grows, without
+     * calling back. All that is left here is deciding when to stop, with
+     * one call per 'followbottom' window rather than one per change.
+     */
+    WebPage *page = m_follow_page;
+    VimPageHelper::run(page, "followState()",
+        [this, page] (const QVariant& res) {
+            if (page != m_follow_page)
+                return;
+
+            const QVariantList state = res.toList();
+            if (2 != state.size()) {
+                stopFollowingBottom();
+                return;
+            }
+
+            const int remaining = state.at(0).toInt();
+            const int since_growth = state.at(1).toInt();
+            const int idle = m_config->option("followbottom").toInt();
+            if (remaining > 0) {
+                /* Still catching up, done in about one key press. */
+                m_follow_timer.start(m_config->singleStepInterval()
+                        * m_config->numScrollSteps());
+                return;
+            }
+            if (since_growth >= idle) {
+                stopFollowingBottom();
+                return;
+            }
+            m_follow_timer.start(idle - since_growth);
+        });
+}
+
+void VimEngine::stopAnimations()
+{
+    stopScroll();
+    stopFollowingBottom();
+}
+
+void VimEngine::applicationStateChanged(Qt::ApplicationState state)
+{
+    if (Qt::ApplicationActive != state)
+        stopAnimations();
+}
+
+void VimEngine::focusWindowChanged(QWindow *window)
+{
+    QWidget *view = m_page ? m_page->view() : nullptr;
+    if (!view || !window || view->window()->windowHandle() != window)
+        stopAnimations();
+}
+
+void VimEngine::stopFollowingBottom()
+{
+    if (!m_follow_page)
+        return;
+
+    m_follow_timer.stop();
+    VimPageHelper::run(m_follow_page, "stopFollowing()");
+    m_follow_page = nullptr;
+}
+
+void VimEngine::jumpToOutline(const QString &kind, int count)
+{
+    stopScroll();
+    recordJump();
+    QPointer<WebPage> page = m_page;
+    VimPageHelper::run(page, QString("jumpToOutline('%1', %2)")
+            .arg(kind).arg(count),
+        [this, page, kind, count] (const QVariant& res) {
+            if (!page)
+                return;
+            if (!res.toBool()) {
+                showMessage(QString("No %1 %2 found")
+                        .arg(count < 0 ? "previous" : "next").arg(kind));
+                return;
+            }
+            if (page == m_page)
+                syncBoundPages(false, true);
+        });
+}
+
+void VimEngine::openOutline()
+{
+    stopScroll();
+    delete m_outline_picker;
+    QPointer<WebPage> page = m_page;
+    VimPageHelper::run(page, QString("outline(%1)").arg(m_max_outline_text),
+        [this, page] (const QVariant& res) {
+            const QVariantList entries = res.toList();
+            if (!page || page != m_page)
+                return;
+            if (entries.isEmpty()) {
+                showMessage("No headings or landmarks found");
+                return;
+            }
+
+            delete m_outline_picker;
+            m_outline_picker = new VimOutlinePicker(page->view());
+            connect(m_outline_picker, SIGNAL(entrySelected(int)),
+                    this, SLOT(jumpToOutlineEntry(int)));
+            m_outline_picker->open(entries);
+        });
+}
+
+void VimEngine::jumpToOutlineEntry(int index)
+{
+    if (!m_page)
+        return;
+
+    recordJump();
+    VimPageHelper::run(m_page, QString("jumpToListing(%1)").arg(index));
+    syncBoundPages(false, true);
+}
+
+VimMarks::Position VimEngine::currentPosition() const
+{
+    return {m_page->url(), m_page->scrollPosition()};
+}
+
+void VimEngine::recordJump()
+{
+    m_marks.recordJump(currentPosition());
+}
+
+void VimEngine::jumpOlder()
+{
+    VimMarks::Position target;
+    if (m_marks.jumpOlder(currentPosition(), &target))
+        jumpTo(target);
+}
+
+void VimEngine::jumpNewer()
+{
+    VimMarks::Position target;
+    if (m_marks.jumpNewer(&target))
+        jumpTo(target);
+}
+
+void VimEngine::jumpTo(const VimMarks::Position &target)
+{
+    stopScroll();
+
+    if (VimMarks::sameDocument(target.url, m_page->url())) {
+        m_page->runJavaScript(QString("window.scrollTo(%1, %2);")
+                .arg(target.pos.x()).arg(target.pos.y()));
+        syncBoundPages(true, true);
+        return;
+    }
+
+    /* Global marks and jumps may point to another document, which is
+     * loaded and scrolled as soon as its layout allows.
+     */
+    m_page->view()->load(target.url);
+    m_scroll_memory.restoreWhenReady(m_page, target.url, target.pos);
+}
+
+int VimEngine::takeCount()
+{
+    const int count = qMax(1, m_count);
+    m_count = 0;
+    return count;
+}
+
+bool VimEngine::isZoomAction(VimConfig::ActionType type)
+{
+    return VimConfig::ZoomIn == type || VimConfig::ZoomOut == type
+        || VimConfig::ZoomReset == type;
+}
+
+bool VimEngine::isOutlineMotion(VimConfig::ActionType type)
+{
+    return VimConfig::NextHeading == type
+        || VimConfig::PreviousHeading == type
+        || VimConfig::NextLandmark == type
+        || VimConfig::PreviousLandmark == type
+        || VimConfig::NextParagraph == type
+        || VimConfig::PreviousParagraph == type;
+}
+
+bool VimEngine::isScrollAction(VimConfig::ActionType type)
+{
+    return VimConfig::ScrollLeft == type || VimConfig::ScrollDown == type
+        || VimConfig::ScrollUp == type || VimConfig::ScrollRight == type
+        || VimConfig::ScrollHalfPageDown == type
+        || VimConfig::ScrollHalfPageUp == type;
+}
+
+void VimEngine::scrollSteps(int step_hor, int step_vert, int count,
+        QKeyEvent *event)
+{
+    /* In a batch only the distance the animation would cover matters. */
+    if (m_batch.active) {
+        flushBatchTabs();
+        m_batch.scroll_hor += step_hor * count * m_config->numScrollSteps();
+        m_batch.scroll_vert += step_vert * count * m_config->numScrollSteps();
+        return;
+    }
+
+    m_scroll_key = event ? event->key() : 0;
+    startScroll(step_hor * count, step_vert * count);
+}
+
+void VimEngine::replayMacro(QChar name, int count)
+{
+    if ('@' == name) {
+        if (m_last_macro_register.isNull()) {
+            showMessage("E748: No previously used register");
+            return;
+        }
+        name = m_last_macro_register;
+    }
+
+    const QVector<VimMacros::Step> steps = m_macros.macro(name);
+    if (steps.isEmpty())
+        return;
+    m_last_macro_register = name.toLower();
+
+    /* The outermost replay owns the batch, macros calling macros just add
+     * to it. The step budget stops macros calling themselves in a loop, the
+     * depth limit the ones nesting deeper and deeper.
+     */
+    const bool outermost = !m_batch.active;
+    if (outermost) {
+        m_replay_budget = m_max_replay_steps;
+        m_replay_depth = 0;
+        beginBatch();
+    }
+
+    if (m_replay_depth >= m_max_replay_depth) {
+        m_replay_budget = 0;
+        return;
+    }
+    ++m_replay_depth;
+
+    for (int i = 0; i < count && m_replay_budget > 0; ++i) {
+        foreach (const VimMacros::Step &step, steps) {
+            if (m_replay_budget <= 0)
+                break;
+            --m_replay_budget;
+            if (VimConfig::takesArgument(step.action.type))
+                runArgumentAction(step.action.type, step.argument, step.count);
+            else
+                runAction(step.action, nullptr, step.count);
+        }
+    }
+    --m_replay_depth;
+
+    if (outermost) {
+        endBatch();
+        if (m_replay_budget <= 0)
+            showMessage("E169: Command too recursive");
+    }
+}
+
+void VimEngine::beginBatch()
+{
+    stopScroll();
+    m_scroll_memory.cancelRestore(m_page);
+    m_batch = Batch();
+    m_batch.active = true;
+}
+
+void VimEngine::endBatch()
+{
+    flushBatch();
+    m_batch.active = false;
+}
+
+void VimEngine::flushBatch()
+{
+    flushBatchScroll();
+    flushBatchTabs();
+}
+
+void VimEngine::flushBatchScroll()
+{
+    if (!m_page) {
+        m_batch.scroll_edge = m_batch.scroll_hor = m_batch.scroll_vert = 0;
+        return;
+    }
+
+    /* Calls are queued in order, the edge is reached before moving on. */
+    if (m_batch.scroll_edge) {
+        VimPageHelper::run(m_page, QString("scrollToEdge(%1)")
+                .arg(m_batch.scroll_edge));
+    }
+    if (m_batch.scroll_hor || m_batch.scroll_vert) {
+        VimPageHelper::run(m_page, QString("scrollBy(%1, %2)")
+                .arg(m_batch.scroll_hor).arg(m_batch.scroll_vert));
+    }
+    if (m_batch.scroll_edge || m_batch.scroll_hor || m_batch.scroll_vert)
+        syncBoundPages(true, true);
+    m_batch.scroll_edge = m_batch.scroll_hor = m_batch.scroll_vert = 0;
+}
+
+void VimEngine::flushBatchTabs()
+{
+    const int offset = m_batch.tab_offset;
+    m_batch.tab_offset = 0;
+
+    TabWidget *tab_widget = tabWidget();
+    if (!offset || !tab_widget || !tab_widget->count())
+        return;
+
+    const int count = tab_widget->count();
+    const int index =
+        ((tab_widget->currentIndex() + offset) % count + count) % count;
+    tab_widget->setCurrentIndex(index);
+
+    /* Later steps act on the tab switched to. */
+    if (tab_widget->webTab(index))
+        m_page = tab_widget->webTab(index)->webView()->page();
+}
+
+void VimEngine::followPageLink(const QString &rel)
+{
+    QPointer<WebPage> page = m_page;
+    VimPageHelper::run(page, QString("pageLink(%1)").arg(pageLinkArguments(rel)),
+        [this, page, rel] (const QVariant& res) {
+            const QUrl url(res.toString());
+            if (!page || url.isEmpty()) {
+                showMessage(QString("No %1 page link found")
+                        .arg("next" == rel ? "next" : "previous"));
+                return;
+            }
+
+            /* Each page reached with ']]' prefetches its own next one in
+             * the same direction.
+             */
+            connect(page, SIGNAL(loadFinished(bool)),
+                    this, SLOT(prefetchPageLink(bool)), Qt::UniqueConnection);
+            m_paging_pages.insert(page, {rel, url});
+            page->view()->load(url);
+        });
+}
+
+QString VimEngine::pageLinkArguments(const QString &rel) const
+{
+    const QString option = "next" == rel ? "nextpatterns" : "previouspatterns";
+    const QStringList patterns = m_config->option(option).toString()
+        .split(',', QString::SkipEmptyParts);
+    return QString("'%1', %2").arg(rel).arg(QString::fromUtf8(
+                QJsonDocument(QJsonArray::fromStringList(patterns))
+                    .toJson(QJsonDocument::Compact)));
+}
+
+const VimUrlMatcher::Verdict& VimEngine::verdictFor(WebPage *page)
+{
+    /* Matching only happens when a page is first seen or its URL changes,
+     * key events just read the cached verdict.
+     */
+    auto it = m_page_verdicts.find(page);
+    if (it != m_page_verdicts.end())
+        return *it;
+
+    connect(page, SIGNAL(urlChanged(QUrl)), this, SLOT(pageUrlChanged()),
+            Qt::UniqueConnection);
+    return *m_page_verdicts.insert(page, m_config->exclusion(page->url()));
+}
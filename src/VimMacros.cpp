@@ -0,0 +1,74 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimMacros.h"
+
+VimMacros::VimMacros()
+    : m_registers()
+    , m_recording()
+    , m_recording_register()
+    , m_append(false)
+{
+}
+
+bool VimMacros::startRecording(QChar name)
+{
+    if (registerIndex(name) < 0)
+        return false;
+
+    m_recording.clear();
+    m_recording_register = name.toLower();
+    m_append = name.isUpper();
+    return true;
+}
+
+void VimMacros::stopRecording()
+{
+    if (!isRecording())
+        return;
+
+    QVector<Step> &steps = m_registers[registerIndex(m_recording_register)];
+    if (m_append)
+        steps += m_recording;
+    else
+        steps = m_recording;
+
+    m_recording.clear();
+    m_recording_register = QChar();
+    m_append = false;
+}
+
+void VimMacros::record(const Step &step)
+{
+    if (isRecording())
+        m_recording.append(step);
+}
+
+QVector<VimMacros::Step> VimMacros::macro(QChar name) const
+{
+    const int index = registerIndex(name);
+    return index < 0 ? QVector<Step>() : m_registers[index];
+}
+
+int VimMacros::registerIndex(QChar name)
+{
+    const QChar lower = name.toLower();
+    if (lower < 'a' || lower > 'z')
+        return -1;
+    return lower.unicode() - 'a';
+}
@@ -0,0 +1,255 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimMarks.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QtEndian>
+
+#include <cstring>
+
+/* Global marks file layout (little endian):
+ *
+ *   header: "VIMM" magic, quint32 version
+ *   26 slots, one per mark 'A'-'Z':
+ *       qint32 x, qint32 y, quint16 url size, url (utf-8, zero padded)
+ *
+ * An url size of zero means the mark is not set.
+ */
+const QString VimMarks::m_global_file_name("vimplugin-marks.dat");
+const int VimMarks::m_global_slot_size = 1024;
+const int VimMarks::m_global_header_size = 8;
+
+static const char global_marks_magic[] = "VIMM";
+static const quint32 global_marks_version = 1;
+static const int global_marks_count = 26;
+static const int global_mark_url_offset = 10;
+
+VimMarks::VimMarks()
+    : m_local_marks()
+    , m_jumps()
+    , m_jump_i(0)
+    , m_last_jump()
+    , m_has_last_jump(false)
+    , m_settings_path()
+    , m_global_file()
+    , m_global_map(nullptr)
+{
+}
+
+VimMarks::~VimMarks()
+{
+    if (m_global_map)
+        m_global_file.unmap(m_global_map);
+}
+
+void VimMarks::setSettingsPath(const QString &settings_path)
+{
+    m_settings_path = settings_path;
+}
+
+bool VimMarks::setMark(QChar name, const Position &position)
+{
+    if (name >= 'a' && name <= 'z') {
+        for (int i = m_local_marks.size() - 1; i >= 0; --i) {
+            LocalMark &mark = m_local_marks[i];
+            if (mark.name == name
+                    && sameDocument(mark.position.url, position.url)) {
+                mark.position = position;
+                return true;
+            }
+        }
+        m_local_marks.append({name, position});
+        return true;
+    }
+
+    if (name >= 'A' && name <= 'Z') {
+        if (!mapGlobalMarks())
+            return false;
+        writeGlobalMark(name.unicode() - 'A', position);
+        return true;
+    }
+
+    return false;
+}
+
+bool VimMarks::mark(QChar name, const QUrl &cur_url, Position *res)
+{
+    if (name >= 'a' && name <= 'z') {
+        /* Newest first, an older mark with the same name may have been
+         * left behind by the ring buffer wrapping around.
+         */
+        for (int i = m_local_marks.size() - 1; i >= 0; --i) {
+            const LocalMark &mark = m_local_marks.at(i);
+            if (mark.name == name && sameDocument(mark.position.url, cur_url)) {
+                *res = mark.position;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (name >= 'A' && name <= 'Z') {
+        if (!mapGlobalMarks())
+            return false;
+        return readGlobalMark(name.unicode() - 'A', res);
+    }
+
+    return false;
+}
+
+void VimMarks::recordJump(const Position &origin)
+{
+    /* Like a browser history, jumping from the middle of the list forgets
+     * the newer entries.
+     */
+    m_jumps.truncate(m_jump_i);
+    m_jumps.append(origin);
+    m_jump_i = m_jumps.size();
+
+    m_last_jump = origin;
+    m_has_last_jump = true;
+}
+
+bool VimMarks::jumpOlder(const Position &current, Position *res)
+{
+    if (m_jumps.isEmpty())
+        return false;
+
+    /* Leaving the end of the list saves where we are so Ctrl-I can come
+     * back to it.
+     */
+    if (m_jump_i >= m_jumps.size()) {
+        m_jumps.append(current);
+        m_jump_i = m_jumps.size() - 1;
+    }
+
+    if (0 == m_jump_i)
+        return false;
+
+    --m_jump_i;
+    *res = m_jumps.at(m_jump_i);
+    return true;
+}
+
+bool VimMarks::jumpNewer(Position *res)
+{
+    if (m_jump_i + 1 >= m_jumps.size())
+        return false;
+
+    ++m_jump_i;
+    *res = m_jumps.at(m_jump_i);
+    return true;
+}
+
+bool VimMarks::previousContext(const Position &current, Position *res)
+{
+    if (!m_has_last_jump)
+        return false;
+
+    *res = m_last_jump;
+    recordJump(current);
+    return true;
+}
+
+bool VimMarks::sameDocument(const QUrl &a, const QUrl &b)
+{
+    return a.adjusted(QUrl::RemoveFragment) == b.adjusted(QUrl::RemoveFragment);
+}
+
+bool VimMarks::mapGlobalMarks()
+{
+    if (m_global_map)
+        return true;
+
+    if (m_settings_path.isEmpty())
+        return false;
+
+    const qint64 file_size =
+        m_global_header_size + global_marks_count * m_global_slot_size;
+
+    m_global_file.setFileName(QDir(m_settings_path).filePath(m_global_file_name));
+    if (!m_global_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "VimPlugin: cannot open" << m_global_file.fileName();
+        return false;
+    }
+
+    /* A file from another version or a truncated one is started over, marks
+     * are not worth a migration.
+     */
+    const QByteArray header = m_global_file.read(m_global_header_size);
+    const bool valid = m_global_file.size() == file_size
+        && header.startsWith(global_marks_magic)
+        && qFromLittleEndian<quint32>(
+                reinterpret_cast<const uchar *>(header.constData()) + 4)
+            == global_marks_version;
+    if (!valid) {
+        m_global_file.resize(0);
+        m_global_file.resize(file_size);
+    }
+
+    m_global_map = m_global_file.map(0, file_size);
+    if (!m_global_map) {
+        qWarning() << "VimPlugin: cannot map" << m_global_file.fileName();
+        m_global_file.close();
+        return false;
+    }
+
+    if (!valid) {
+        std::memcpy(m_global_map, global_marks_magic, 4);
+        qToLittleEndian<quint32>(global_marks_version, m_global_map + 4);
+    }
+
+    return true;
+}
+
+void VimMarks::writeGlobalMark(int slot, const Position &position)
+{
+    uchar *data = m_global_map + m_global_header_size + slot * m_global_slot_size;
+    const int max_url_size = m_global_slot_size - global_mark_url_offset;
+
+    QByteArray url = position.url.toEncoded();
+    if (url.size() > max_url_size)
+        url = position.url.adjusted(QUrl::RemoveQuery | QUrl::RemoveFragment)
+                  .toEncoded().left(max_url_size);
+
+    std::memset(data, 0, m_global_slot_size);
+    qToLittleEndian<qint32>(qRound(position.pos.x()), data);
+    qToLittleEndian<qint32>(qRound(position.pos.y()), data + 4);
+    qToLittleEndian<quint16>(url.size(), data + 8);
+    std::memcpy(data + global_mark_url_offset, url.constData(), url.size());
+}
+
+bool VimMarks::readGlobalMark(int slot, Position *res) const
+{
+    const uchar *data =
+        m_global_map + m_global_header_size + slot * m_global_slot_size;
+    const int max_url_size = m_global_slot_size - global_mark_url_offset;
+
+    const int url_size = qFromLittleEndian<quint16>(data + 8);
+    if (!url_size || url_size > max_url_size)
+        return false;
+
+    res->pos = QPointF(qFromLittleEndian<qint32>(data),
+                       qFromLittleEndian<qint32>(data + 4));
+    res->url = QUrl::fromEncoded(QByteArray(
+                reinterpret_cast<const char *>(data + global_mark_url_offset),
+                url_size));
+    return true;
+}
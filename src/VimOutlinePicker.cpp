@@ -0,0 +1,91 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimOutlinePicker.h"
+
+#include <QKeyEvent>
+
+VimOutlinePicker::VimOutlinePicker(QWidget *parent)
+    : QListWidget(parent)
+{
+    setUniformItemSizes(true);
+    setWordWrap(false);
+    setTextElideMode(Qt::ElideRight);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    hide();
+}
+
+void VimOutlinePicker::open(const QVariantList &entries)
+{
+    foreach (const QVariant &entry, entries) {
+        const QVariantList fields = entry.toList();
+        const int level = fields.value(0).toInt();
+        const QString text = fields.value(1).toString();
+        addItem(0 == level ? QString("[%1]").arg(text)
+                           : QString(2 * (level - 1), ' ') + text);
+    }
+    setCurrentRow(0);
+
+    if (parentWidget())
+        setGeometry(parentWidget()->rect());
+    show();
+    raise();
+    setFocus();
+}
+
+void VimOutlinePicker::keyPressEvent(QKeyEvent *event)
+{
+    const QString text = event->text();
+
+    if (Qt::Key_Escape == event->key()) {
+        leave();
+        return;
+    }
+
+    if (Qt::Key_Return == event->key() || Qt::Key_Enter == event->key()) {
+        const int row = currentRow();
+        leave();
+        if (row >= 0)
+            emit entrySelected(row);
+        return;
+    }
+
+    if ("j" == text || "k" == text) {
+        QKeyEvent move(QEvent::KeyPress,
+                "j" == text ? Qt::Key_Down : Qt::Key_Up, Qt::NoModifier);
+        QListWidget::keyPressEvent(&move);
+        return;
+    }
+
+    QListWidget::keyPressEvent(event);
+}
+
+void VimOutlinePicker::focusOutEvent(QFocusEvent *event)
+{
+    QListWidget::focusOutEvent(event);
+    if (isVisible())
+        leave();
+}
+
+void VimOutlinePicker::leave()
+{
+    hide();
+    if (parentWidget())
+        parentWidget()->setFocus();
+    deleteLater();
+}
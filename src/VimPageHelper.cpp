@@ -0,0 +1,94 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimPageHelper.h"
+
+#include <QFile>
+#include <QWebEngineProfile>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+
+#include "mainapplication.h"
+#include "browserwindow.h"
+#include "tabwidget.h"
+#include "webpage.h"
+#include "webtab.h"
+#include "webview.h"
+
+const QString VimPageHelper::m_script_name("_vimplugin_helper");
+
+void VimPageHelper::install()
+{
+    QWebEngineScriptCollection *scripts = mApp->webProfile()->scripts();
+    if (!scripts->findScript(m_script_name).isNull())
+        return;
+
+    QWebEngineScript script;
+    script.setName(m_script_name);
+    script.setSourceCode(source());
+    script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+    script.setWorldId(WebPage::SafeJsWorld);
+    /* The main frame's helper reaches same-origin frames on its own. */
+    script.setRunsOnSubFrames(false);
+    scripts->insert(script);
+
+    /* Pages loaded before the plugin only get the script on their next
+     * load, give them the helper right away. It ignores a second install.
+     */
+    foreach (BrowserWindow *window, mApp->windows()) {
+        foreach (WebTab *tab, window->tabWidget()->allTabs()) {
+            tab->webView()->page()->runJavaScript(script.sourceCode(),
+                    WebPage::SafeJsWorld);
+        }
+    }
+}
+
+void VimPageHelper::uninstall()
+{
+    QWebEngineScriptCollection *scripts = mApp->webProfile()->scripts();
+    const QWebEngineScript script = scripts->findScript(m_script_name);
+    if (!script.isNull())
+        scripts->remove(script);
+}
+
+void VimPageHelper::run(WebPage *page, const QString &call)
+{
+    page->runJavaScript(expression(call), WebPage::SafeJsWorld);
+}
+
+void VimPageHelper::run(WebPage *page, const QString &call,
+        const std::function<void (const QVariant &)> &callback)
+{
+    page->runJavaScript(expression(call), WebPage::SafeJsWorld, callback);
+}
+
+QString VimPageHelper::source()
+{
+    QFile file(":/vimplugin/data/vimhelper.js");
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromUtf8(file.readAll());
+}
+
+QString VimPageHelper::expression(const QString &call)
+{
+    /* Pages where scripts are not injected, like about:blank, just get an
+     * undefined result.
+     */
+    return QString("window.__vimHelper && window.__vimHelper.%1").arg(call);
+}
@@ -17,6 +17,7 @@
 * ============================================================ */
 
 #include "VimPlugin.h"
+#include "VimPageHelper.h"
 
 #include <QWebEngineView>
 
@@ -56,10 +57,13 @@ void VimPlugin::init(InitState state, const QString &settingsPath)
     qDebug() << __FUNCTION__ << "called";
 
     Q_UNUSED(state)
-    Q_UNUSED(settingsPath);
+
+    m_vim_engine.setSettingsPath(settingsPath);
 
     connect(mApp->plugins(), SIGNAL(webPageDeleted(WebPage *)),
         &m_vim_engine, SLOT(stopScrollingIfPageWasDeleted(WebPage *)));
+    connect(mApp->plugins(), SIGNAL(webPageDeleted(WebPage *)),
+        &m_vim_engine, SLOT(forgetPage(WebPage *)));
 
     mApp->plugins()->registerAppEventHandler(PluginProxy::KeyPressHandler, this);
     mApp->plugins()->registerAppEventHandler(PluginProxy::KeyReleaseHandler, this);
@@ -73,6 +77,7 @@ bool VimPlugin::testPlugin()
 
 void VimPlugin::unload()
 {
+    VimPageHelper::uninstall();
 }
 
 bool VimPlugin::keyPress(const Qz::ObjectName &type, QObject* obj,
@@ -84,6 +89,9 @@ bool VimPlugin::keyPress(const Qz::ObjectName &type, QObject* obj,
     if (!view)
         return false;
 
+    if (m_vim_engine.isExcluded(view->page()))
+        return false;
+
     m_vim_engine.handleKeyPressEvent(view->page(), event);
 
     return false;
@@ -98,7 +106,18 @@ bool VimPlugin::keyRelease(const Qz::ObjectName &type, QObject* obj,
     if (!view)
         return false;
 
+    if (m_vim_engine.isExcluded(view->page()))
+        return false;
+
     m_vim_engine.handleKeyReleaseEvent(view->page(), event);
 
     return false;
 }
+
+bool VimPlugin::acceptNavigationRequest(WebPage *page, const QUrl &url,
+        QWebEnginePage::NavigationType type, bool isMainFrame)
+{
+    m_vim_engine.handleNavigationRequest(page, url, type, isMainFrame);
+
+    return true;
+}
@@ -0,0 +1,95 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimPrefixIndex.h"
+
+#include <QRegularExpression>
+#include <QUrl>
+
+#include <algorithm>
+
+void VimPrefixIndex::addItem(const Item &item, const QStringList &keys)
+{
+    const int item_i = m_items.size();
+    m_items.append(item);
+    foreach (const QString &key, keys) {
+        if (!key.isEmpty())
+            m_keys.append(qMakePair(key.toLower(), item_i));
+    }
+}
+
+void VimPrefixIndex::finalize()
+{
+    std::sort(m_keys.begin(), m_keys.end());
+    m_keys.erase(std::unique(m_keys.begin(), m_keys.end()), m_keys.end());
+    m_keys.squeeze();
+    m_items.squeeze();
+}
+
+QVector<VimPrefixIndex::Item> VimPrefixIndex::complete(const QString &prefix,
+        int limit) const
+{
+    QVector<Item> res;
+
+    /* Without a prefix the items are returned in the order they were added,
+     * which is the ranking of the source (tab order, visit count, etc).
+     */
+    if (prefix.isEmpty()) {
+        for (int i = 0; i < m_items.size() && res.size() < limit; ++i)
+            res.append(m_items.at(i));
+        return res;
+    }
+
+    const QString key = prefix.toLower();
+    auto it = std::lower_bound(m_keys.constBegin(), m_keys.constEnd(),
+            qMakePair(key, -1));
+
+    /* An item shows up once per key, so the few already returned are
+     * remembered to skip duplicates. 'limit' is small, a linear search is
+     * cheaper than any set here.
+     */
+    QVector<int> seen;
+    for (; it != m_keys.constEnd() && res.size() < limit; ++it) {
+        if (!it->first.startsWith(key))
+            break;
+        if (seen.contains(it->second))
+            continue;
+        seen.append(it->second);
+        res.append(m_items.at(it->second));
+    }
+
+    return res;
+}
+
+QStringList VimPrefixIndex::keysForPage(const QString &title,
+        const QString &url)
+{
+    static const QRegularExpression word_separator("[^\\w]+");
+
+    QStringList keys = title.split(word_separator, QString::SkipEmptyParts);
+
+    const QUrl qurl(url);
+    QString host = qurl.host();
+    if (host.startsWith("www."))
+        host.remove(0, 4);
+    keys << host;
+    keys << host + qurl.path();
+    keys << url;
+
+    return keys;
+}
@@ -0,0 +1,167 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimScrollMemory.h"
+
+#include <QPointer>
+
+#include "webpage.h"
+#include "webview.h"
+
+const int VimScrollMemory::m_max_urls = 256;
+
+VimScrollMemory::VimScrollMemory(QObject *parent)
+    : QObject(parent)
+    , m_positions(m_max_urls)
+    , m_pending()
+{
+}
+
+void VimScrollMemory::remember(const QUrl &url, const QPointF &pos)
+{
+    if (url.isEmpty())
+        return;
+
+    /* Top of the page is where every load starts anyway. */
+    if (pos.isNull()) {
+        m_positions.remove(key(url));
+        return;
+    }
+
+    m_positions.insert(key(url), new QPointF(pos));
+}
+
+void VimScrollMemory::restoreWhenReady(WebPage *page, const QUrl &url)
+{
+    const QPointF *pos = m_positions.object(key(url));
+    if (pos)
+        restoreWhenReady(page, url, *pos);
+}
+
+void VimScrollMemory::restoreWhenReady(WebPage *page, const QUrl &url,
+        const QPointF &pos)
+{
+    if (!page)
+        return;
+
+    if (!m_pending.contains(page)) {
+        connect(page, SIGNAL(contentsSizeChanged(QSizeF)),
+                this, SLOT(contentsSizeChanged(QSizeF)));
+        connect(page, SIGNAL(loadFinished(bool)),
+                this, SLOT(loadFinished()));
+        connect(page, SIGNAL(destroyed(QObject*)),
+                this, SLOT(pageDestroyed(QObject*)));
+    }
+    m_pending.insert(page, {key(url), pos, false, false});
+
+    /* Each document has its own globals, the next one starts without. */
+    page->runJavaScript("window.__vimScrollLeaving = true;",
+            WebPage::SafeJsWorld);
+}
+
+void VimScrollMemory::cancelRestore(WebPage *page)
+{
+    if (!m_pending.remove(page))
+        return;
+
+    disconnect(page, nullptr, this, nullptr);
+}
+
+void VimScrollMemory::cancelRestoreUnlessFor(WebPage *page, const QUrl &url)
+{
+    if (m_pending.contains(page) && m_pending.value(page).url_key != key(url))
+        cancelRestore(page);
+}
+
+void VimScrollMemory::contentsSizeChanged(const QSizeF &size)
+{
+    WebPage *page = static_cast<WebPage *>(sender());
+    if (!m_pending.contains(page))
+        return;
+
+    /* Restore as soon as the target is within the scrollable range of the
+     * laid out content, so the user does not see the page jump after it
+     * was fully painted. Only axes with an offset to restore count: pages
+     * are usually narrower than the view and never scroll sideways.
+     */
+    const QPointF pos = m_pending.value(page).pos;
+    const qreal zoom = page->zoomFactor() > 0 ? page->zoomFactor() : 1;
+    const QSizeF viewport = page->view()
+        ? QSizeF(page->view()->size()) / zoom : QSizeF();
+    const bool x_ready = pos.x() <= 0
+        || size.width() - viewport.width() >= pos.x();
+    const bool y_ready = pos.y() <= 0
+        || size.height() - viewport.height() >= pos.y();
+    if (x_ready && y_ready)
+        restore(page);
+}
+
+void VimScrollMemory::loadFinished()
+{
+    /* Last chance: the page is as tall as it gets, go as far as possible. */
+    restore(static_cast<WebPage *>(sender()));
+}
+
+void VimScrollMemory::pageDestroyed(QObject *page)
+{
+    m_pending.remove(static_cast<WebPage *>(page));
+}
+
+QString VimScrollMemory::key(const QUrl &url)
+{
+    return url.adjusted(QUrl::RemoveFragment).toString();
+}
+
+void VimScrollMemory::restore(WebPage *page)
+{
+    auto it = m_pending.find(page);
+    if (it == m_pending.end())
+        return;
+    if (it->in_flight) {
+        it->retry = true;
+        return;
+    }
+    it->in_flight = true;
+    it->retry = false;
+
+    const PendingRestore pending = *it;
+    QPointer<WebPage> guarded_page = page;
+    page->runJavaScript(QString("window.__vimScrollLeaving ? false"
+                " : (window.scrollTo(%1, %2), true)")
+            .arg(pending.pos.x()).arg(pending.pos.y()), WebPage::SafeJsWorld,
+        [this, guarded_page, pending] (const QVariant &res) {
+            WebPage *page = guarded_page.data();
+            auto it = m_pending.find(page);
+            if (!page || it == m_pending.end()
+                    || it->url_key != pending.url_key || !it->in_flight)
+                return;
+
+            /* Still the document being left, the next size change or the
+             * end of the load tries again.
+             */
+            if (!res.toBool()) {
+                it->in_flight = false;
+                if (it->retry)
+                    restore(page);
+                return;
+            }
+
+            cancelRestore(page);
+            emit restored(page, pending.pos);
+        });
+}
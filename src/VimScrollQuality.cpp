@@ -0,0 +1,125 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimScrollQuality.h"
+
+#include <QtGlobal>
+
+/* Lag samples in a mode before it may change again. */
+const int VimScrollQuality::m_min_samples = 8;
+const int VimScrollQuality::m_degrade_frames = 4;
+const int VimScrollQuality::m_recover_frames = 2;
+/* Steps not seen after this long moved nothing, like at the bottom of a
+ * page or in an inner scroller, whose scrolling the page does not report.
+ */
+const int VimScrollQuality::m_max_lag = 2000;
+
+VimScrollQuality::VimScrollQuality()
+    : m_mode(Smooth)
+    , m_oldest_request()
+    , m_pending(0)
+    , m_average_lag(0)
+    , m_samples(0)
+    , m_requested(0)
+    , m_observed(0)
+    , m_unobserved(0)
+    , m_max_seen_lag(0)
+    , m_reductions(0)
+    , m_recoveries(0)
+{
+}
+
+int VimScrollQuality::steps(int full_steps) const
+{
+    switch (m_mode) {
+        case Reduced:
+            return qMax(1, (full_steps + 2) / 3);
+        case Instant:
+            return 1;
+        default:
+            return full_steps;
+    }
+}
+
+void VimScrollQuality::stepRequested()
+{
+    ++m_requested;
+    if (m_pending > 0 && m_oldest_request.elapsed() > m_max_lag) {
+        m_unobserved += m_pending;
+        m_pending = 0;
+    }
+    if (0 == m_pending)
+        m_oldest_request.start();
+    ++m_pending;
+}
+
+void VimScrollQuality::positionChanged(int frame_ms)
+{
+    /* The user scrolling on their own, with the mouse for instance, tells
+     * nothing about our steps.
+     */
+    if (0 == m_pending)
+        return;
+
+    /* A paint shows every step sent before it, which is how a saturated
+     * renderer catches up.
+     */
+    const int lag = m_oldest_request.elapsed();
+    m_observed += m_pending;
+    m_pending = 0;
+    if (lag > m_max_lag)
+        return;
+
+    m_max_seen_lag = qMax(m_max_seen_lag, lag);
+    m_average_lag = 0 == m_samples ? lag
+                                   : m_average_lag + (lag - m_average_lag) / 4;
+    if (++m_samples < m_min_samples)
+        return;
+
+    if (m_average_lag > m_degrade_frames * frame_ms && Instant != m_mode) {
+        ++m_reductions;
+        setMode(Smooth == m_mode ? Reduced : Instant);
+    }
+    else if (m_average_lag <= m_recover_frames * frame_ms
+            && Smooth != m_mode) {
+        ++m_recoveries;
+        setMode(Instant == m_mode ? Reduced : Smooth);
+    }
+}
+
+void VimScrollQuality::reset()
+{
+    *this = VimScrollQuality();
+}
+
+QString VimScrollQuality::summary() const
+{
+    static const char *const mode_names[] = {"smooth", "reduced", "instant"};
+    return QString("scroll %1, lag %2 ms (max %3), %4 steps, %5 seen, "
+            "%6 unseen, %7 reduction(s), %8 recovery(ies)")
+        .arg(mode_names[m_mode]).arg(m_average_lag).arg(m_max_seen_lag)
+        .arg(m_requested).arg(m_observed).arg(m_unobserved)
+        .arg(m_reductions).arg(m_recoveries);
+}
+
+void VimScrollQuality::setMode(Mode mode)
+{
+    m_mode = mode;
+    /* The average carried over belongs to the old step rate. */
+    m_samples = 0;
+}
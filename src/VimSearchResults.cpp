@@ -0,0 +1,98 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimSearchResults.h"
+
+#include <QKeyEvent>
+
+#include "webtab.h"
+
+VimSearchResults::VimSearchResults(QWidget *parent)
+    : QListWidget(parent)
+    , m_tabs()
+{
+    setUniformItemSizes(true);
+    setWordWrap(false);
+    setTextElideMode(Qt::ElideRight);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    hide();
+}
+
+void VimSearchResults::open()
+{
+    if (parentWidget())
+        setGeometry(parentWidget()->rect());
+    show();
+    raise();
+    setFocus();
+}
+
+void VimSearchResults::addMatch(WebTab *tab, const QString &title,
+        const QString &snippet, int match_count)
+{
+    m_tabs.append(tab);
+    addItem(QString("%1 (%2)\n    %3").arg(title).arg(match_count)
+            .arg(snippet));
+
+    /* The first match is selected, later ones must not move the user. */
+    if (1 == count())
+        setCurrentRow(0);
+}
+
+void VimSearchResults::keyPressEvent(QKeyEvent *event)
+{
+    const QString text = event->text();
+
+    if (Qt::Key_Escape == event->key()) {
+        leave();
+        return;
+    }
+
+    if (Qt::Key_Return == event->key() || Qt::Key_Enter == event->key()) {
+        const int row = currentRow();
+        WebTab *tab = row >= 0 ? m_tabs.value(row).data() : nullptr;
+        if (tab)
+            emit matchSelected(tab);
+        leave();
+        return;
+    }
+
+    if ("j" == text || "k" == text) {
+        QKeyEvent move(QEvent::KeyPress,
+                "j" == text ? Qt::Key_Down : Qt::Key_Up, Qt::NoModifier);
+        QListWidget::keyPressEvent(&move);
+        return;
+    }
+
+    QListWidget::keyPressEvent(event);
+}
+
+void VimSearchResults::focusOutEvent(QFocusEvent *event)
+{
+    QListWidget::focusOutEvent(event);
+    if (isVisible())
+        leave();
+}
+
+void VimSearchResults::leave()
+{
+    hide();
+    if (parentWidget())
+        parentWidget()->setFocus();
+    deleteLater();
+}
@@ -0,0 +1,146 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimSelection.h"
+#include "VimPageHelper.h"
+
+#include <QApplication>
+#include <QClipboard>
+
+#include "webpage.h"
+
+const int VimSelection::m_flush_interval = 16;
+const int VimSelection::m_max_motion_count = 9999;
+
+VimSelection::VimSelection(QObject *parent)
+    : QObject(parent)
+    , m_mode(Off)
+    , m_page(nullptr)
+    , m_motions()
+    , m_flush_timer()
+{
+    m_flush_timer.setSingleShot(true);
+    m_flush_timer.setInterval(m_flush_interval);
+    connect(&m_flush_timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+void VimSelection::enter(WebPage *page, Mode mode)
+{
+    if (Off == mode) {
+        leave();
+        return;
+    }
+
+    /* Switching pages drops the selection left behind. */
+    if (m_page && page != m_page)
+        leave();
+
+    flush();
+    m_page = page;
+    m_mode = mode;
+    VimPageHelper::run(m_page, QString("enterSelection('%1')").arg(modeName()));
+}
+
+void VimSelection::leave()
+{
+    if (Off == m_mode)
+        return;
+
+    m_flush_timer.stop();
+    m_motions.clear();
+    VimPageHelper::run(m_page, "leaveSelection()");
+    m_mode = Off;
+    m_page = nullptr;
+}
+
+void VimSelection::forgetPage(WebPage *page)
+{
+    if (page != m_page)
+        return;
+
+    m_flush_timer.stop();
+    m_motions.clear();
+    m_mode = Off;
+    m_page = nullptr;
+}
+
+bool VimSelection::isMotion(QChar key)
+{
+    return QString("hjklwb$0").contains(key);
+}
+
+bool VimSelection::move(QChar motion, int count)
+{
+    if (Off == m_mode || !isMotion(motion))
+        return false;
+
+    if (!m_motions.isEmpty() && m_motions.last().key == motion) {
+        m_motions.last().count = qMin(m_motions.last().count + count,
+                m_max_motion_count);
+    }
+    else {
+        m_motions.append({motion, qMin(count, m_max_motion_count)});
+    }
+
+    /* Not restarted by further motions: a held key flushes every frame. */
+    if (!m_flush_timer.isActive())
+        m_flush_timer.start();
+    return true;
+}
+
+void VimSelection::yank()
+{
+    if (Off == m_mode)
+        return;
+
+    /* Calls on a page run in order, the yank sees every motion before it. */
+    flush();
+    VimPageHelper::run(m_page, "yankSelection()",
+        [this] (const QVariant& res) {
+            const QString text = res.toString();
+            if (!text.isEmpty())
+                QApplication::clipboard()->setText(text);
+            emit yanked(text.size());
+        });
+
+    m_mode = Off;
+    m_page = nullptr;
+}
+
+void VimSelection::flush()
+{
+    m_flush_timer.stop();
+    if (m_motions.isEmpty() || !m_page)
+        return;
+
+    QString motions;
+    for (const Motion &motion : m_motions) {
+        if (motion.count > 1)
+            motions += QString::number(motion.count);
+        motions += '0' == motion.key ? QChar('^') : motion.key;
+    }
+    m_motions.clear();
+
+    VimPageHelper::run(m_page, QString("moveSelection('%1', '%2')")
+            .arg(modeName(), motions));
+}
+
+QString VimSelection::modeName() const
+{
+    return Visual == m_mode ? "visual" : "caret";
+}
@@ -0,0 +1,178 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimSessionRecorder.h"
+
+#include <QKeyEvent>
+
+#include "tabwidget.h"
+#include "webpage.h"
+#include "webview.h"
+
+/* "VIMS" */
+const quint32 VimSessionRecorder::m_magic = 0x56494d53;
+const quint16 VimSessionRecorder::m_version = 1;
+
+VimSessionRecorder::VimSessionRecorder(QObject *parent)
+    : QObject(parent)
+    , m_file()
+    , m_stream()
+    , m_clock()
+    , m_tab_widget()
+    , m_last_url()
+    , m_count(0)
+{
+}
+
+bool VimSessionRecorder::start(const QString &file_path,
+        TabWidget *tab_widget, QString *error)
+{
+    stop();
+
+    m_file.setFileName(file_path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = m_file.errorString();
+        return false;
+    }
+
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_5_0);
+    m_stream << m_magic << m_version;
+    m_clock.start();
+    m_last_url.clear();
+    m_count = 0;
+
+    m_tab_widget = tab_widget;
+    if (m_tab_widget) {
+        connect(m_tab_widget, SIGNAL(currentChanged(int)),
+                this, SLOT(tabChanged()));
+        tabChanged();
+    }
+    return true;
+}
+
+int VimSessionRecorder::stop()
+{
+    if (m_tab_widget)
+        disconnect(m_tab_widget, nullptr, this, nullptr);
+    m_tab_widget = nullptr;
+
+    if (!isRecording())
+        return 0;
+
+    m_stream.setDevice(nullptr);
+    m_file.close();
+    return m_count;
+}
+
+void VimSessionRecorder::recordKey(WebPage *page, const QKeyEvent *event)
+{
+    if (!isRecording() || isTyping(page))
+        return;
+
+    if (page && page->url() != m_last_url) {
+        m_last_url = page->url();
+        write(Url);
+        m_stream << m_last_url.toString();
+    }
+
+    write(QEvent::KeyPress == event->type() ? KeyPress : KeyRelease);
+    m_stream << qint32(event->key()) << quint32(event->modifiers())
+        << event->isAutoRepeat() << event->text();
+}
+
+bool VimSessionRecorder::isTyping(WebPage *page)
+{
+    /* The view only takes input method events while an editable element
+     * of the page has focus, password fields included.
+     */
+    const QWidget *view = page && page->view()
+        ? page->view()->focusProxy() : nullptr;
+    return view && view->inputMethodQuery(Qt::ImEnabled).toBool();
+}
+
+void VimSessionRecorder::tabChanged()
+{
+    if (!isRecording() || !m_tab_widget)
+        return;
+
+    write(Tabs);
+    m_stream << quint16(m_tab_widget->count())
+        << quint16(qMax(0, m_tab_widget->currentIndex()));
+}
+
+void VimSessionRecorder::write(EventType type)
+{
+    ++m_count;
+    m_stream << quint8(type) << quint32(m_clock.elapsed());
+}
+
+QVector<VimSessionRecorder::Event> VimSessionRecorder::read(
+        QIODevice *device, QString *error)
+{
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version;
+    if (m_magic != magic || m_version != version) {
+        *error = "Not a session recording";
+        return QVector<Event>();
+    }
+
+    QVector<Event> events;
+    while (!stream.atEnd()) {
+        quint8 type = 0;
+        Event event = {KeyPress, 0, 0, Qt::NoModifier, false, QString(),
+                       QUrl(), 0, 0};
+        stream >> type >> event.time_ms;
+
+        if (KeyPress == type || KeyRelease == type) {
+            qint32 key = 0;
+            quint32 modifiers = 0;
+            stream >> key >> modifiers >> event.auto_repeat >> event.text;
+            event.key = key;
+            event.modifiers = Qt::KeyboardModifiers(modifiers);
+        }
+        else if (Url == type) {
+            QString url;
+            stream >> url;
+            event.url = QUrl(url);
+        }
+        else if (Tabs == type) {
+            quint16 count = 0;
+            quint16 current = 0;
+            stream >> count >> current;
+            event.tab_count = count;
+            event.current_tab = current;
+        }
+        else {
+            *error = QString("Unknown event type %1").arg(type);
+            return events;
+        }
+
+        if (QDataStream::Ok != stream.status()) {
+            *error = "Truncated session recording";
+            return events;
+        }
+        event.type = EventType(type);
+        events.append(event);
+    }
+    return events;
+}
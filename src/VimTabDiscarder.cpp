@@ -0,0 +1,238 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimTabDiscarder.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <QWebEngineHistory>
+
+#include <algorithm>
+
+#include "tabbedwebview.h"
+#include "tabwidget.h"
+#include "webpage.h"
+
+const int VimTabDiscarder::m_report_delay = 1000;
+
+VimTabDiscarder::VimTabDiscarder(QObject *parent)
+    : QObject(parent)
+    , m_last_activation()
+    , m_discarded()
+    , m_memory_before_kb(-1)
+    , m_pending_count(0)
+{
+}
+
+void VimTabDiscarder::watch(TabWidget *tab_widget)
+{
+    if (!tab_widget)
+        return;
+
+    connect(tab_widget, SIGNAL(currentChanged(int)),
+            this, SLOT(tabActivated(int)), Qt::UniqueConnection);
+}
+
+int VimTabDiscarder::discard(TabWidget *tab_widget, int count)
+{
+    if (!tab_widget || count <= 0)
+        return 0;
+
+    watch(tab_widget);
+
+    const QList<WebTab *> candidates = discardCandidates(tab_widget);
+    const int to_discard = qMin(count, candidates.size());
+    if (!to_discard)
+        return 0;
+
+    /* Only the first operation of a burst takes the baseline, so several
+     * ':discard' in a row are reported together.
+     */
+    if (!m_pending_count)
+        m_memory_before_kb = rendererMemoryKb();
+
+    for (int i = 0; i < to_discard; ++i)
+        discardTab(candidates.at(i));
+
+    m_pending_count += to_discard;
+    QTimer::singleShot(m_report_delay, this, SLOT(reportReclaimed()));
+
+    return to_discard;
+}
+
+qint64 VimTabDiscarder::rendererMemoryKb()
+{
+#ifdef Q_OS_LINUX
+    /* Renderers are not direct children of the browser (they are forked
+     * by the zygote), so the whole process tree below us is walked.
+     */
+    QHash<qint64, qint64> parents;
+    const QStringList pids = QDir("/proc").entryList(QDir::Dirs);
+    foreach (const QString &pid, pids) {
+        bool is_pid = false;
+        const qint64 pid_n = pid.toLongLong(&is_pid);
+        if (!is_pid)
+            continue;
+
+        QFile stat(QString("/proc/%1/stat").arg(pid));
+        if (!stat.open(QIODevice::ReadOnly))
+            continue;
+        /* "pid (comm) state ppid ...", comm may contain spaces. */
+        const QByteArray line = stat.readAll();
+        const QList<QByteArray> fields =
+            line.mid(line.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() > 1)
+            parents.insert(pid_n, fields.at(1).toLongLong());
+    }
+
+    const qint64 app_pid = QCoreApplication::applicationPid();
+    qint64 total_kb = 0;
+    for (auto it = parents.constBegin(); it != parents.constEnd(); ++it) {
+        qint64 ancestor = it.value();
+        while (ancestor > 1 && ancestor != app_pid)
+            ancestor = parents.value(ancestor, 0);
+        if (ancestor != app_pid)
+            continue;
+
+        QFile cmdline(QString("/proc/%1/cmdline").arg(it.key()));
+        if (!cmdline.open(QIODevice::ReadOnly)
+                || !cmdline.readAll().contains("--type=renderer"))
+            continue;
+
+        QFile status(QString("/proc/%1/status").arg(it.key()));
+        if (!status.open(QIODevice::ReadOnly))
+            continue;
+        foreach (const QByteArray &status_line, status.readAll().split('\n')) {
+            if (status_line.startsWith("VmRSS:")) {
+                total_kb += status_line.mid(6).simplified()
+                                .split(' ').first().toLongLong();
+                break;
+            }
+        }
+    }
+
+    return total_kb;
+#else
+    return -1;
+#endif
+}
+
+void VimTabDiscarder::tabActivated(int index)
+{
+    TabWidget *tab_widget = qobject_cast<TabWidget *>(sender());
+    if (!tab_widget)
+        return;
+
+    WebTab *tab = tab_widget->webTab(index);
+    if (!tab)
+        return;
+
+    if (!m_last_activation.contains(tab)) {
+        connect(tab, SIGNAL(destroyed(QObject*)),
+                this, SLOT(tabDestroyed(QObject*)), Qt::UniqueConnection);
+    }
+    m_last_activation.insert(tab, QDateTime::currentMSecsSinceEpoch());
+
+    if (m_discarded.contains(tab))
+        restoreTab(tab);
+}
+
+void VimTabDiscarder::tabDestroyed(QObject *tab)
+{
+    /* Only used as a key, the object is already half destroyed here. */
+    m_last_activation.remove(static_cast<WebTab *>(tab));
+    m_discarded.remove(static_cast<WebTab *>(tab));
+}
+
+void VimTabDiscarder::reportReclaimed()
+{
+    /* Each discard schedules a report; only the last one of a burst
+     * arrives after every renderer involved had its time to exit.
+     */
+    if (!m_pending_count)
+        return;
+
+    const qint64 memory_after_kb = rendererMemoryKb();
+    qint64 reclaimed_kb = -1;
+    if (m_memory_before_kb >= 0 && memory_after_kb >= 0)
+        reclaimed_kb = qMax(qint64(0), m_memory_before_kb - memory_after_kb);
+
+    const int count = m_pending_count;
+    m_pending_count = 0;
+    emit discarded(count, reclaimed_kb);
+}
+
+QList<WebTab *> VimTabDiscarder::discardCandidates(
+        TabWidget *tab_widget) const
+{
+    const int current = tab_widget->currentIndex();
+
+    QList<WebTab *> candidates;
+    foreach (WebTab *tab, tab_widget->allTabs()) {
+        if (tab->tabIndex() != current && !tab->isPinned()
+                && tab->isRestored() && !isDiscarded(tab))
+            candidates.append(tab);
+    }
+
+    /* Least recently activated first. Tabs never activated since we started
+     * watching go before all others, farthest from the current tab first.
+     */
+    std::sort(candidates.begin(), candidates.end(),
+        [this, current] (WebTab *a, WebTab *b) {
+            const qint64 a_time = m_last_activation.value(a, 0);
+            const qint64 b_time = m_last_activation.value(b, 0);
+            if (a_time != b_time)
+                return a_time < b_time;
+            return qAbs(a->tabIndex() - current)
+                > qAbs(b->tabIndex() - current);
+        });
+
+    return candidates;
+}
+
+void VimTabDiscarder::discardTab(WebTab *tab)
+{
+    const WebTab::SavedTab saved(tab);
+    m_discarded.insert(tab, saved);
+    connect(tab, SIGNAL(destroyed(QObject*)),
+            this, SLOT(tabDestroyed(QObject*)), Qt::UniqueConnection);
+
+    /* Replacing the page deletes the old one and with it its renderer. The
+     * new one only holds an empty document at the old URL.
+     */
+    WebPage *page = new WebPage();
+    tab->webView()->setPage(page);
+    page->setHtml(QString("<title>%1</title>")
+            .arg(saved.title.toHtmlEscaped()), saved.url);
+}
+
+void VimTabDiscarder::restoreTab(WebTab *tab)
+{
+    /* Same steps as WebTab restoring a session tab. */
+    const WebTab::SavedTab saved = m_discarded.take(tab);
+    tab->webView()->load(saved.url);
+    if (!saved.history.isEmpty()) {
+        QDataStream stream(saved.history);
+        stream >> *tab->webView()->history();
+    }
+    tab->webView()->setZoomLevel(saved.zoomLevel);
+}
@@ -0,0 +1,184 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimTabPicker.h"
+#include "VimThumbnailCache.h"
+
+#include <QHash>
+#include <QKeyEvent>
+
+#include "tabwidget.h"
+#include "webtab.h"
+
+const int VimTabPickerModel::m_max_decoded = 64;
+
+VimTabPickerModel::VimTabPickerModel(TabWidget *tab_widget,
+        const VimThumbnailCache *thumbnails, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_thumbnails(thumbnails)
+    , m_tabs()
+    , m_titles()
+    , m_decoded(m_max_decoded)
+    , m_placeholder(VimThumbnailCache::thumbnailSize())
+{
+    m_placeholder.fill(Qt::lightGray);
+
+    /* Tab texts are used rather than page titles: a discarded tab keeps
+     * its text while its page is blank.
+     */
+    for (int i = 0; i < tab_widget->count(); ++i) {
+        m_tabs.append(tab_widget->webTab(i));
+        m_titles.append(QString("%1: %2").arg(i + 1)
+                .arg(tab_widget->tabText(i)));
+    }
+
+    connect(thumbnails, SIGNAL(captured(WebTab*)),
+            this, SLOT(thumbnailCaptured(WebTab*)));
+}
+
+int VimTabPickerModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_tabs.size();
+}
+
+QVariant VimTabPickerModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_tabs.size())
+        return QVariant();
+
+    if (Qt::DisplayRole == role || Qt::ToolTipRole == role)
+        return m_titles.at(index.row());
+
+    if (Qt::DecorationRole != role)
+        return QVariant();
+
+    if (QPixmap *decoded = m_decoded.object(index.row()))
+        return *decoded;
+
+    const QImage thumbnail = m_thumbnails->thumbnail(m_tabs.at(index.row()));
+    if (thumbnail.isNull())
+        return m_placeholder;
+
+    QPixmap *pixmap = new QPixmap(QPixmap::fromImage(thumbnail));
+    m_decoded.insert(index.row(), pixmap);
+    return *pixmap;
+}
+
+void VimTabPickerModel::thumbnailCaptured(WebTab *tab)
+{
+    const int row = m_tabs.indexOf(tab);
+    if (row < 0)
+        return;
+
+    m_decoded.remove(row);
+    emit dataChanged(index(row), index(row), {Qt::DecorationRole});
+}
+
+VimTabPicker::VimTabPicker(TabWidget *tab_widget,
+        const VimThumbnailCache *thumbnails, QWidget *parent)
+    : QListView(parent)
+    , m_model(tab_widget, thumbnails, this)
+{
+    const QSize icon_size = VimThumbnailCache::thumbnailSize();
+
+    /* Uniform items keep layout cost flat with hundreds of tabs. */
+    setModel(&m_model);
+    setViewMode(QListView::IconMode);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setUniformItemSizes(true);
+    setWordWrap(false);
+    setTextElideMode(Qt::ElideRight);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setIconSize(icon_size);
+    setGridSize(icon_size + QSize(24, 32));
+    setSpacing(8);
+
+    setCurrentIndex(m_model.index(qMax(0, tab_widget->currentIndex())));
+    hide();
+}
+
+void VimTabPicker::open()
+{
+    if (parentWidget())
+        setGeometry(parentWidget()->rect());
+    show();
+    raise();
+    setFocus();
+    scrollTo(currentIndex());
+}
+
+void VimTabPicker::keyPressEvent(QKeyEvent *event)
+{
+    const QString text = event->text();
+
+    if (Qt::Key_Escape == event->key()) {
+        leave();
+        return;
+    }
+
+    if (Qt::Key_Return == event->key() || Qt::Key_Enter == event->key()
+            || Qt::Key_Space == event->key()) {
+        select(currentIndex().row());
+        return;
+    }
+
+    if (1 == text.size() && text.at(0) >= '1' && text.at(0) <= '9') {
+        select(text.toInt() - 1);
+        return;
+    }
+
+    static const QHash<QString, int> vim_moves = {
+        {"h", Qt::Key_Left},
+        {"j", Qt::Key_Down},
+        {"k", Qt::Key_Up},
+        {"l", Qt::Key_Right}
+    };
+    if (vim_moves.contains(text)) {
+        QKeyEvent move(QEvent::KeyPress, vim_moves.value(text),
+                Qt::NoModifier);
+        QListView::keyPressEvent(&move);
+        return;
+    }
+
+    QListView::keyPressEvent(event);
+}
+
+void VimTabPicker::focusOutEvent(QFocusEvent *event)
+{
+    QListView::focusOutEvent(event);
+    if (isVisible())
+        leave();
+}
+
+void VimTabPicker::select(int row)
+{
+    if (row < 0 || row >= m_model.rowCount())
+        return;
+
+    emit tabSelected(row);
+    leave();
+}
+
+void VimTabPicker::leave()
+{
+    hide();
+    if (parentWidget())
+        parentWidget()->setFocus();
+    deleteLater();
+}
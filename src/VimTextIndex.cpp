@@ -0,0 +1,246 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimTextIndex.h"
+#include "VimPageHelper.h"
+
+#include <QtConcurrent>
+
+#include "mainapplication.h"
+#include "browserwindow.h"
+#include "tabbedwebview.h"
+#include "tabwidget.h"
+#include "webpage.h"
+#include "webtab.h"
+
+const int VimTextIndex::m_extract_delay = 300;
+const int VimTextIndex::m_max_text_length = 2 * 1024 * 1024;
+
+namespace {
+
+/* QtConcurrent::mapped wants a result_type on its functor. */
+struct SearchEntry {
+    typedef VimTextIndex::Match result_type;
+
+    explicit SearchEntry(const QString &text)
+        : text(text)
+    {
+    }
+
+    VimTextIndex::Match operator()(const VimTextIndex::Entry &entry) const
+    {
+        const QString page_text = QString::fromUtf8(qUncompress(entry.text));
+        const int first_i = page_text.indexOf(text, 0, Qt::CaseInsensitive);
+        if (first_i < 0)
+            return {entry.tab, entry.title, QString(), 0};
+
+        int count = 0;
+        for (int i = first_i; i >= 0;
+                i = page_text.indexOf(text, i + text.size(), Qt::CaseInsensitive))
+            ++count;
+
+        const int context = 40;
+        const int start = qMax(0, first_i - context);
+        const QString snippet = page_text.mid(start,
+                first_i - start + text.size() + context).simplified();
+        return {entry.tab, entry.title, snippet, count};
+    }
+
+    QString text;
+};
+
+}
+
+VimTextIndex::VimTextIndex(QObject *parent)
+    : QObject(parent)
+    , m_started(false)
+    , m_entries()
+    , m_queue()
+    , m_extract_timer()
+    , m_compressing()
+    , m_search()
+    , m_search_text()
+    , m_search_matches(0)
+{
+    m_extract_timer.setSingleShot(true);
+    m_extract_timer.setInterval(m_extract_delay);
+    connect(&m_extract_timer, SIGNAL(timeout()), this, SLOT(extractNext()));
+    connect(&m_search, SIGNAL(resultReadyAt(int)),
+            this, SLOT(matchReady(int)));
+    connect(&m_search, SIGNAL(finished()), this, SLOT(searchDone()));
+}
+
+void VimTextIndex::start()
+{
+    if (m_started)
+        return;
+    m_started = true;
+
+    /* Tabs already loaded are read in the background, one at a time. */
+    foreach (BrowserWindow *window, mApp->windows()) {
+        foreach (WebTab *tab, window->tabWidget()->allTabs()) {
+            WebPage *page = tab->webView()->page();
+            watchPage(page);
+            if (!tab->isLoading())
+                enqueue(page);
+        }
+    }
+}
+
+void VimTextIndex::watchPage(WebPage *page)
+{
+    if (!m_started || !page)
+        return;
+
+    connect(page, SIGNAL(loadFinished(bool)), this, SLOT(pageChanged()),
+            Qt::UniqueConnection);
+    connect(page, SIGNAL(urlChanged(QUrl)), this, SLOT(pageChanged()),
+            Qt::UniqueConnection);
+}
+
+void VimTextIndex::search(const QString &text)
+{
+    cancel();
+    if (text.isEmpty())
+        return;
+
+    m_search_text = text;
+    m_search_matches = 0;
+    /* Entries are implicitly shared, the snapshot copies no text. */
+    m_search.setFuture(QtConcurrent::mapped(m_entries.values(),
+                SearchEntry(text)));
+}
+
+void VimTextIndex::cancel()
+{
+    /* An empty future is finished and canceled already: results of the
+     * previous search still on their way are dropped.
+     */
+    m_search.cancel();
+    m_search.setFuture(QFuture<Match>());
+}
+
+qint64 VimTextIndex::compressedBytes() const
+{
+    qint64 bytes = 0;
+    foreach (const Entry &entry, m_entries)
+        bytes += entry.text.size();
+    return bytes;
+}
+
+void VimTextIndex::pageChanged()
+{
+    enqueue(qobject_cast<WebPage *>(sender()));
+}
+
+void VimTextIndex::extractNext()
+{
+    while (!m_queue.isEmpty()) {
+        QPointer<WebPage> page = m_queue.takeFirst();
+        if (!page)
+            continue;
+
+        VimPageHelper::run(page, QString("visibleText(%1)").arg(m_max_text_length),
+            [this, page] (const QVariant &res) {
+                if (page)
+                    store(page, res.toString());
+            });
+        break;
+    }
+
+    if (!m_queue.isEmpty())
+        m_extract_timer.start();
+}
+
+void VimTextIndex::compressed()
+{
+    QFutureWatcher<QByteArray> *watcher =
+        static_cast<QFutureWatcher<QByteArray> *>(sender());
+    Entry entry = m_compressing.take(watcher);
+    watcher->deleteLater();
+
+    if (!entry.tab)
+        return;
+    entry.text = watcher->result();
+    m_entries.insert(entry.tab, entry);
+}
+
+void VimTextIndex::matchReady(int index)
+{
+    const Match match = m_search.resultAt(index);
+    /* The tab may have been closed while the search ran. */
+    if (!match.count || !m_entries.contains(match.tab))
+        return;
+
+    ++m_search_matches;
+    emit found(match.tab, match.title, match.snippet, match.count);
+}
+
+void VimTextIndex::searchDone()
+{
+    if (!m_search.isCanceled())
+        emit searchFinished(m_search_text, m_search_matches);
+}
+
+void VimTextIndex::tabDestroyed(QObject *tab)
+{
+    WebTab *web_tab = static_cast<WebTab *>(tab);
+    m_entries.remove(web_tab);
+
+    for (auto it = m_compressing.begin(); it != m_compressing.end(); ++it) {
+        if (it.value().tab == web_tab)
+            it.value().tab = nullptr;
+    }
+}
+
+void VimTextIndex::enqueue(WebPage *page)
+{
+    if (!m_started || !page || m_queue.contains(page))
+        return;
+
+    m_queue.append(page);
+    if (!m_extract_timer.isActive())
+        m_extract_timer.start();
+}
+
+void VimTextIndex::store(WebPage *page, const QString &text)
+{
+    WebTab *tab = tabOf(page);
+    /* The blank page of a discarded tab must not replace its text. */
+    if (!tab || page->url().isEmpty())
+        return;
+
+    connect(tab, SIGNAL(destroyed(QObject*)),
+            this, SLOT(tabDestroyed(QObject*)), Qt::UniqueConnection);
+
+    QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>(this);
+    m_compressing.insert(watcher, {tab, page->title(), QByteArray()});
+    connect(watcher, SIGNAL(finished()), this, SLOT(compressed()));
+    watcher->setFuture(QtConcurrent::run(&VimTextIndex::compress, text));
+}
+
+WebTab* VimTextIndex::tabOf(WebPage *page)
+{
+    TabbedWebView *view = qobject_cast<TabbedWebView *>(page->view());
+    return view ? view->webTab() : nullptr;
+}
+
+QByteArray VimTextIndex::compress(const QString &text)
+{
+    return qCompress(text.toUtf8());
+}
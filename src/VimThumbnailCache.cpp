@@ -0,0 +1,165 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimThumbnailCache.h"
+
+#include <QBuffer>
+#include <QtConcurrent>
+
+#include "tabwidget.h"
+#include "webtab.h"
+#include "webview.h"
+
+const QSize VimThumbnailCache::m_thumbnail_size(240, 150);
+const int VimThumbnailCache::m_jpeg_quality = 60;
+
+VimThumbnailCache::VimThumbnailCache(QObject *parent)
+    : QObject(parent)
+    , m_thumbnails()
+    , m_current_tabs()
+    , m_encoding()
+    , m_known_tabs()
+{
+}
+
+void VimThumbnailCache::watch(TabWidget *tab_widget)
+{
+    if (!tab_widget || m_current_tabs.contains(tab_widget))
+        return;
+
+    WebTab *current = tab_widget->webTab();
+    if (current)
+        current->installEventFilter(this);
+    m_current_tabs.insert(tab_widget, current);
+    connect(tab_widget, SIGNAL(currentChanged(int)),
+            this, SLOT(tabActivated(int)));
+    connect(tab_widget, SIGNAL(destroyed(QObject*)),
+            this, SLOT(tabWidgetDestroyed(QObject*)));
+}
+
+void VimThumbnailCache::setBudget(int bytes)
+{
+    /* Shrinking the budget drops the least recently used previews. */
+    m_thumbnails.setMaxCost(bytes);
+}
+
+void VimThumbnailCache::capture(WebTab *tab)
+{
+    if (!tab || !tab->webView() || tab->webView()->size().isEmpty())
+        return;
+
+    /* Grabbing has to happen in the UI thread, scaling and compressing a
+     * full size frame does not.
+     */
+    const QImage image = tab->webView()->grab().toImage();
+    if (image.isNull())
+        return;
+
+    if (!m_known_tabs.contains(tab)) {
+        m_known_tabs.insert(tab);
+        connect(tab, SIGNAL(destroyed(QObject*)),
+                this, SLOT(tabDestroyed(QObject*)));
+    }
+
+    QFutureWatcher<QByteArray> *watcher = new QFutureWatcher<QByteArray>(this);
+    m_encoding.insert(watcher, tab);
+    connect(watcher, SIGNAL(finished()), this, SLOT(encoded()));
+    watcher->setFuture(QtConcurrent::run(&VimThumbnailCache::encode, image));
+}
+
+QImage VimThumbnailCache::thumbnail(WebTab *tab) const
+{
+    const QByteArray *data = m_thumbnails.object(tab);
+    return data ? QImage::fromData(*data, "JPG") : QImage();
+}
+
+void VimThumbnailCache::tabActivated(int index)
+{
+    TabWidget *tab_widget = qobject_cast<TabWidget *>(sender());
+    if (!tab_widget)
+        return;
+
+    /* Only the current tab is watched for being hidden, it was already
+     * grabbed when this is called.
+     */
+    WebTab *previous = m_current_tabs.value(tab_widget);
+    WebTab *current = tab_widget->webTab(index);
+    if (previous == current)
+        return;
+
+    if (previous)
+        previous->removeEventFilter(this);
+    if (current)
+        current->installEventFilter(this);
+    m_current_tabs.insert(tab_widget, current);
+}
+
+bool VimThumbnailCache::eventFilter(QObject *obj, QEvent *event)
+{
+    /* The stack hides the tab being left before it shows the next one and
+     * before it reports the change, and the tab gets its hide event before
+     * its view does: this is the last moment its frame is there to grab.
+     */
+    if (QEvent::Hide == event->type() && !event->spontaneous())
+        capture(static_cast<WebTab *>(obj));
+    return false;
+}
+
+void VimThumbnailCache::tabDestroyed(QObject *tab)
+{
+    WebTab *web_tab = static_cast<WebTab *>(tab);
+    m_thumbnails.remove(web_tab);
+    m_known_tabs.remove(web_tab);
+
+    for (auto it = m_encoding.begin(); it != m_encoding.end(); ++it) {
+        if (it.value() == web_tab)
+            it.value() = nullptr;
+    }
+}
+
+void VimThumbnailCache::tabWidgetDestroyed(QObject *tab_widget)
+{
+    m_current_tabs.remove(static_cast<TabWidget *>(tab_widget));
+}
+
+void VimThumbnailCache::encoded()
+{
+    QFutureWatcher<QByteArray> *watcher =
+        static_cast<QFutureWatcher<QByteArray> *>(sender());
+    WebTab *tab = m_encoding.take(watcher);
+    watcher->deleteLater();
+
+    const QByteArray data = watcher->result();
+    if (!tab || data.isEmpty())
+        return;
+
+    m_thumbnails.insert(tab, new QByteArray(data), data.size());
+    emit captured(tab);
+}
+
+QByteArray VimThumbnailCache::encode(const QImage &image)
+{
+    const QImage small = image.scaled(m_thumbnail_size, Qt::KeepAspectRatio,
+            Qt::SmoothTransformation);
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    small.save(&buffer, "JPG", m_jpeg_quality);
+    return data;
+}
@@ -0,0 +1,145 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimUrlMatcher.h"
+
+/* Captures the authority of patterns like "https://mail.google.com/*" or
+ * "*://docs.google.com:8080/*" when it has no wildcard.
+ */
+static const QRegularExpression literal_host_pattern(
+        "^[^/]*://([^/*?]+)(/.*)?$");
+
+VimUrlMatcher::VimUrlMatcher()
+    : m_host_rules()
+    , m_groups()
+    , m_rule_count(0)
+{
+}
+
+bool VimUrlMatcher::addRule(const QString &pattern, const QString &pass_keys)
+{
+    if (pattern.isEmpty())
+        return false;
+
+    /* URLs are matched as QUrl writes them, with a lower case host. */
+    const QString url_pattern = withLowerCaseHost(pattern);
+    const QRegularExpression regexp(
+            QString("^%1$").arg(toRegExp(url_pattern)));
+    if (!regexp.isValid())
+        return false;
+
+    ++m_rule_count;
+
+    /* The bucket is looked up with QUrl::host(): no user info, no port. */
+    const QRegularExpressionMatch host_match =
+        literal_host_pattern.match(url_pattern);
+    const QString host = host_match.hasMatch()
+        ? QUrl("http://" + host_match.captured(1)).host() : QString();
+    if (!host.isEmpty()) {
+        m_host_rules[host].append({regexp, pass_keys});
+        return true;
+    }
+
+    Group &group = m_groups[pass_keys];
+    group.patterns << toRegExp(url_pattern);
+    group.pass_keys = pass_keys;
+    return true;
+}
+
+void VimUrlMatcher::finalize()
+{
+    for (auto it = m_groups.begin(); it != m_groups.end(); ++it) {
+        it->regexp = QRegularExpression(
+                QString("^(?:%1)$").arg(it->patterns.join('|')));
+        it->regexp.optimize();
+        it->patterns.clear();
+    }
+
+    for (auto it = m_host_rules.begin(); it != m_host_rules.end(); ++it) {
+        for (Rule &rule : *it)
+            rule.regexp.optimize();
+    }
+}
+
+VimUrlMatcher::Verdict VimUrlMatcher::match(const QUrl &url) const
+{
+    Verdict verdict = {false, QString()};
+    if (!m_rule_count || url.isEmpty())
+        return verdict;
+
+    const QString url_string = url.toString();
+
+    const auto host_it = m_host_rules.constFind(url.host().toLower());
+    if (host_it != m_host_rules.constEnd()) {
+        for (const Rule &rule : *host_it) {
+            if (rule.regexp.match(url_string).hasMatch())
+                merge(&verdict, rule.pass_keys);
+            if (verdict.disabled)
+                return verdict;
+        }
+    }
+
+    for (const Group &group : m_groups) {
+        if (group.regexp.match(url_string).hasMatch())
+            merge(&verdict, group.pass_keys);
+        if (verdict.disabled)
+            return verdict;
+    }
+
+    return verdict;
+}
+
+QString VimUrlMatcher::withLowerCaseHost(const QString &pattern)
+{
+    const int scheme_end = pattern.indexOf("://");
+    if (scheme_end < 0)
+        return pattern;
+
+    /* User info keeps its case, only what follows the last '@' is host. */
+    const int host_start = qMax(scheme_end + 3,
+            pattern.lastIndexOf('@', pattern.indexOf('/', scheme_end + 3)) + 1);
+    int host_end = pattern.indexOf('/', host_start);
+    if (host_end < 0)
+        host_end = pattern.size();
+
+    QString result = pattern;
+    result.replace(host_start, host_end - host_start,
+            pattern.mid(host_start, host_end - host_start).toLower());
+    return result;
+}
+
+QString VimUrlMatcher::toRegExp(const QString &pattern)
+{
+    QStringList parts = pattern.split('*');
+    for (QString &part : parts)
+        part = QRegularExpression::escape(part);
+    return parts.join(".*");
+}
+
+void VimUrlMatcher::merge(Verdict *verdict, const QString &pass_keys)
+{
+    if (pass_keys.isEmpty()) {
+        verdict->disabled = true;
+        return;
+    }
+
+    for (const QChar &key : pass_keys) {
+        if (!verdict->pass_keys.contains(key))
+            verdict->pass_keys.append(key);
+    }
+}
@@ -20,7 +20,7 @@ mac {
     DEFINES += LIB_VIM_PLUGIN=\\\"""$$DESTDIR/libVimPlugin.dylib"\\\""
 }
 
-QT += webenginewidgets testlib
+QT += webenginewidgets testlib concurrent sql network
 TEMPLATE = app
 TARGET = VimPluginTests
 
@@ -31,12 +31,53 @@ MOC_DIR = ../build
 RCC_DIR = ../build
 DESTDIR = ../build
 
-HEADERS += ../include/VimPlugin.h \
-           ../include/VimEngine.h
+HEADERS += VimSessionReplay.h            \
+           ../include/VimPlugin.h        \
+           ../include/VimEngine.h        \
+           ../include/VimCommandLine.h   \
+           ../include/VimCompleter.h     \
+           ../include/VimConfig.h        \
+           ../include/VimConfigLoader.h  \
+           ../include/VimMacros.h        \
+           ../include/VimMarks.h         \
+           ../include/VimOutlinePicker.h \
+           ../include/VimPageHelper.h    \
+           ../include/VimPrefixIndex.h   \
+           ../include/VimRingBuffer.h    \
+           ../include/VimScrollMemory.h  \
+           ../include/VimScrollQuality.h \
+           ../include/VimSearchResults.h \
+           ../include/VimSelection.h     \
+           ../include/VimSessionRecorder.h \
+           ../include/VimTabDiscarder.h  \
+           ../include/VimTabPicker.h     \
+           ../include/VimTextIndex.h     \
+           ../include/VimThumbnailCache.h \
+           ../include/VimUrlMatcher.h
 
-SOURCES += VimPluginTests.cpp   \
-           ../src/VimPlugin.cpp \
-           ../src/VimEngine.cpp
+SOURCES += VimPluginTests.cpp            \
+           VimSessionReplay.cpp          \
+           ../src/VimPlugin.cpp          \
+           ../src/VimEngine.cpp          \
+           ../src/VimCommandLine.cpp     \
+           ../src/VimCompleter.cpp       \
+           ../src/VimConfig.cpp          \
+           ../src/VimConfigLoader.cpp    \
+           ../src/VimMacros.cpp          \
+           ../src/VimMarks.cpp           \
+           ../src/VimOutlinePicker.cpp   \
+           ../src/VimPageHelper.cpp      \
+           ../src/VimPrefixIndex.cpp     \
+           ../src/VimScrollMemory.cpp    \
+           ../src/VimScrollQuality.cpp   \
+           ../src/VimSearchResults.cpp   \
+           ../src/VimSelection.cpp       \
+           ../src/VimSessionRecorder.cpp \
+           ../src/VimTabDiscarder.cpp    \
+           ../src/VimTabPicker.cpp       \
+           ../src/VimTextIndex.cpp       \
+           ../src/VimThumbnailCache.cpp  \
+           ../src/VimUrlMatcher.cpp
 
 INCLUDEPATH += $$PWD/../include/                        \
                $$qupzilla_src_dir/src/lib/adblock       \
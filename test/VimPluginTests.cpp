@@ -17,8 +17,17 @@
 * ============================================================ */
 
 #include <QtTest/QtTest>
+#include <QClipboard>
+#include <QTcpServer>
+#include <QTcpSocket>
 
 #include "VimPlugin.h"
+#include "VimCommandLine.h"
+#include "VimOutlinePicker.h"
+#include "VimPrefixIndex.h"
+#include "VimSearchResults.h"
+#include "VimSessionReplay.h"
+#include "VimTabPicker.h"
 
 #include "mainapplication.h"
 #include "browserwindow.h"
@@ -26,14 +35,92 @@
 #include "webpage.h"
 #include "pluginproxy.h"
 #include "tabwidget.h"
+#include "webtab.h"
 #include "settings.h"
 #include "datapaths.h"
 
 #define TEST_PROFILE "VimPluginTests"
 #define BIG_TEST_PAGE "w5000px_h5000px.html"
 #define TEST_PAGE "page.html"
+#define INNER_SCROLLER_TEST_PAGE "inner_scroller.html"
 #define BIG_TEST_PAGE_FILEPATH "/tmp/" BIG_TEST_PAGE
 #define TEST_PAGE_FILEPATH "/tmp/" TEST_PAGE
+#define INNER_SCROLLER_TEST_PAGE_FILEPATH "/tmp/" INNER_SCROLLER_TEST_PAGE
+#define OUTLINE_TEST_PAGE "outline.html"
+#define OUTLINE_TEST_PAGE_FILEPATH "/tmp/" OUTLINE_TEST_PAGE
+
+/* Minimal HTTP server standing in for real sites: serves fixed pages and
+ * records every path requested, prefetches included. "/hang" is never
+ * answered, which keeps a page referencing it loading, and paths starting
+ * with "/slow/" are answered after a second.
+ */
+class TestHttpServer : public QTcpServer
+{
+    public:
+        explicit TestHttpServer(const QHash<QString, QByteArray> &pages)
+            : QTcpServer()
+            , m_pages(pages)
+            , m_requested_paths()
+        {
+            connect(this, &QTcpServer::newConnection, [this] () {
+                QTcpSocket *socket = nextPendingConnection();
+                connect(socket, &QTcpSocket::readyRead,
+                        [this, socket] () { respond(socket); });
+                connect(socket, &QTcpSocket::disconnected,
+                        socket, &QObject::deleteLater);
+            });
+            listen(QHostAddress::LocalHost);
+        }
+
+        QUrl url(const QString &path) const
+        {
+            return QUrl(QString("http://127.0.0.1:%1%2")
+                    .arg(serverPort()).arg(path));
+        }
+
+        const QStringList& requestedPaths() const
+        {
+            return m_requested_paths;
+        }
+
+    private:
+        void respond(QTcpSocket *socket)
+        {
+            if (!socket->canReadLine())
+                return;
+
+            const QList<QByteArray> request = socket->readLine().split(' ');
+            socket->readAll();
+            const QString path = QString::fromUtf8(request.value(1));
+            m_requested_paths << path;
+            if ("/hang" == path)
+                return;
+            if (path.startsWith("/slow/")) {
+                QPointer<QTcpSocket> guarded_socket = socket;
+                QTimer::singleShot(1000, [this, guarded_socket, path] () {
+                    if (guarded_socket)
+                        write(guarded_socket, path);
+                });
+                return;
+            }
+            write(socket, path);
+        }
+
+        void write(QTcpSocket *socket, const QString &path)
+        {
+            const QByteArray body = m_pages.value(path);
+            const QByteArray status = m_pages.contains(path) ? "200 OK"
+                                                             : "404 Not Found";
+            socket->write("HTTP/1.1 " + status + "\r\n"
+                    "Content-Type: text/html; charset=utf-8\r\n"
+                    "Content-Length: " + QByteArray::number(body.size())
+                    + "\r\nConnection: close\r\n\r\n" + body);
+            socket->disconnectFromHost();
+        }
+
+        QHash<QString, QByteArray> m_pages;
+        QStringList m_requested_paths;
+};
 
 class VimPluginTests : public QObject
 {
@@ -50,6 +137,10 @@ class VimPluginTests : public QObject
              */
             QFile::copy(":/vimplugin/" BIG_TEST_PAGE, BIG_TEST_PAGE_FILEPATH);
             QFile::copy(":/vimplugin/" TEST_PAGE, TEST_PAGE_FILEPATH);
+            QFile::copy(":/vimplugin/" INNER_SCROLLER_TEST_PAGE,
+                    INNER_SCROLLER_TEST_PAGE_FILEPATH);
+            QFile::copy(":/vimplugin/" OUTLINE_TEST_PAGE,
+                    OUTLINE_TEST_PAGE_FILEPATH);
         }
 
         void cleanupTestCase()
@@ -61,6 +152,8 @@ class VimPluginTests : public QObject
 
             QFile::remove(BIG_TEST_PAGE_FILEPATH);
             QFile::remove(TEST_PAGE_FILEPATH);
+            QFile::remove(INNER_SCROLLER_TEST_PAGE_FILEPATH);
+            QFile::remove(OUTLINE_TEST_PAGE_FILEPATH);
             QDir(DataPaths::currentProfilePath()).removeRecursively();
         }
 
@@ -108,9 +201,64 @@ class VimPluginTests : public QObject
         void CloseCurTabOnLowerCaseX();
 
         void StopScrollingWhenPageIsClosed();
+        void StopScrollingWhenKeyReleaseIsLost();
 
         void RestoreClosedTabOnCapitalX();
 
+        void PrefixIndexCompletesWordPrefixes();
+        void LoadHistoryOnFirstHistoryCompletion();
+        void ShowMessagesInCurrentView();
+
+        void RunCommandsFromCommandLine_data();
+        void RunCommandsFromCommandLine();
+
+        void DiscardBackgroundTabsAndRestoreOnActivation();
+
+        void RestoreScrollPositionOnReload();
+        void RestoreScrollPositionOnBackForward();
+        void RestoreScrollPositionBeforeLoadFinishes();
+        void RestoreScrollPositionInNewDocumentOnly();
+
+        void JumpToLocalMark();
+        void JumpBackAndForthWithCtrlOAndCtrlI();
+        void StoreGlobalMarksInSettingsPath();
+
+        void ReloadKeymapWhenConfigFileChanges();
+        void SetOptionFromCommandLine();
+        void KeepQuotesInMappedCommands();
+
+        void UrlMatcherMatchesExclusionRules();
+        void IgnoreKeysOnExcludedPages_data();
+        void IgnoreKeysOnExcludedPages();
+        void IgnoreFirstKeyOnExcludedPage();
+
+        void ScrollInnerContainerWhenDocumentDoesNotScroll();
+
+        void FollowNextAndPreviousPageLinks();
+
+        void ReplayScrollMacroWithoutAnimation();
+        void ReplayTabMacroAsSingleSwitch();
+        void StopSelfRecursiveMacro();
+
+        void PickTabFromThumbnails();
+
+        void YankSelectionFromCaretAndVisualMode_data();
+        void YankSelectionFromCaretAndVisualMode();
+
+        void ApplyZoomChangesOncePerFrame();
+
+        void SearchTextAcrossTabs();
+
+        void FollowBottomOfGrowingPage();
+
+        void JumpThroughPageStructure();
+        void ScrollBoundPagesTogether();
+        void ReduceScrollStepsWhenPageLags();
+
+        void RecordAndReplaySession();
+        void ReplaySessionFromEnvironment();
+        void SkipFormFieldKeysWhenRecording();
+
     private:
         void startMainApplication()
         {
@@ -169,6 +317,7 @@ class VimPluginTests : public QObject
 
             if (!m_vim_plugin)
                 QFAIL("VimPlugin is not loaded in current QupZilla's profile!");
+            QTRY_VERIFY(m_vim_plugin->vimEngine().configLoader()->isLoaded());
         }
 
         void loadTestPage()
@@ -196,6 +345,17 @@ class VimPluginTests : public QObject
             QTRY_COMPARE(page->scrollPosition().y(), y);
         }
 
+        /* Types 'command' in the ':' line of the current view. */
+        void runCommand(const QString &command)
+        {
+            QTest::keyClick(m_browser_window->weView()->focusProxy(), ':');
+            const VimCommandLine *command_line =
+                m_vim_plugin->vimEngine().commandLine();
+            QTRY_VERIFY(command_line && command_line->isVisible());
+            QTest::keyClicks(QApplication::focusWidget(), command);
+            QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+        }
+
         MainApplication *m_app;
         BrowserWindow *m_browser_window;
         VimPlugin *m_vim_plugin;
@@ -592,6 +752,34 @@ void VimPluginTests::StopScrollingWhenPageIsClosed()
     QTRY_VERIFY(!m_vim_plugin->vimEngine().scrollTimer()->isActive());
 }
 
+void VimPluginTests::StopScrollingWhenKeyReleaseIsLost()
+{
+    TabWidget* tab_widget = m_browser_window->tabWidget();
+    const QTimer *scroll_timer = m_vim_plugin->vimEngine().scrollTimer();
+
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 1);
+    tab_widget->addView(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+
+    /* Switching tabs with 'j' held stops right away. */
+    QTest::keyPress(m_browser_window->weView(1)->focusProxy(), 'j');
+    QVERIFY(scroll_timer->isActive());
+    tab_widget->setCurrentIndex(0);
+    QVERIFY(!scroll_timer->isActive());
+
+    /* A release that never arrives ends it once the key stays silent. */
+    QTest::keyPress(m_browser_window->weView(0)->focusProxy(), 'j');
+    QVERIFY(scroll_timer->isActive());
+    QTRY_VERIFY_WITH_TIMEOUT(!scroll_timer->isActive(), 3000);
+
+    /* The next key press is not cut short by the interrupted one. */
+    QSignalSpy spy(scroll_timer, SIGNAL(timeout()));
+    QTest::keyClick(m_browser_window->weView(0)->focusProxy(), 'j');
+    QTRY_VERIFY(!scroll_timer->isActive());
+    QCOMPARE(spy.count(), VimEngine::numSteps());
+}
+
 void VimPluginTests::RestoreClosedTabOnCapitalX()
 {
     const QUrl url_test_page = QUrl::fromLocalFile(TEST_PAGE_FILEPATH);
@@ -618,6 +806,1165 @@ void VimPluginTests::RestoreClosedTabOnCapitalX()
     QTRY_COMPARE(m_browser_window->weView(1)->page()->url(), url_test_page);
 }
 
+void VimPluginTests::PrefixIndexCompletesWordPrefixes()
+{
+    VimPrefixIndex index;
+    index.addItem({"QupZilla", "1"}, VimPrefixIndex::keysForPage(
+                "QupZilla Web Browser", "https://www.qupzilla.com/"));
+    index.addItem({"Vimium", "2"}, VimPrefixIndex::keysForPage(
+                "Vimium - The Hacker's Browser", "https://vimium.github.io/"));
+    index.addItem({"Qt", "3"}, VimPrefixIndex::keysForPage(
+                "Qt Documentation", "https://doc.qt.io/"));
+    index.finalize();
+
+    QCOMPARE(index.size(), 3);
+    QCOMPARE(index.complete("", 10).size(), 3);
+    QCOMPARE(index.complete("brow", 10).size(), 2);
+    QCOMPARE(index.complete("brow", 1).size(), 1);
+    QCOMPARE(index.complete("DOC", 10).first().value, QString("3"));
+    QCOMPARE(index.complete("vimium.git", 10).first().value, QString("2"));
+    QVERIFY(index.complete("firefox", 10).isEmpty());
+}
+
+void VimPluginTests::ShowMessagesInCurrentView()
+{
+    /* Every test starts in a new tab, whose view never had a ':' line. */
+    WebView *web_view = m_browser_window->weView();
+    QTest::keyClicks(web_view->focusProxy(), "qa");
+
+    const VimCommandLine *command_line =
+        m_vim_plugin->vimEngine().commandLine();
+    QVERIFY(command_line);
+    QCOMPARE(command_line->parentWidget(), static_cast<QWidget *>(web_view));
+    QTRY_VERIFY(command_line->isVisible());
+    QCOMPARE(command_line->text(), QString("recording @a"));
+
+    QTest::keyClick(web_view->focusProxy(), 'q');
+}
+
+void VimPluginTests::LoadHistoryOnFirstHistoryCompletion()
+{
+    const VimCompleter *completer = m_vim_plugin->vimEngine().completer();
+    QTest::keyClick(m_browser_window->weView()->focusProxy(), ':');
+    QTRY_VERIFY(!completer->isRefreshing());
+    QVERIFY(!completer->isHistoryLoaded());
+
+    /* Commands and ':buffer' do not need it. */
+    QWidget *input = QApplication::focusWidget();
+    QTest::keyClicks(input, "buffer ");
+    QTest::keyClick(input, Qt::Key_Tab);
+    QTest::qWait(100);
+    QVERIFY(!completer->isHistoryLoaded());
+
+    QTest::keyClick(input, Qt::Key_Escape);
+    QTest::keyClick(m_browser_window->weView()->focusProxy(), ':');
+    input = QApplication::focusWidget();
+    QTest::keyClicks(input, "open ");
+    QTest::keyClick(input, Qt::Key_Tab);
+    QTRY_VERIFY(completer->isHistoryLoaded());
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Escape);
+}
+
+void VimPluginTests::RunCommandsFromCommandLine_data()
+{
+    QTest::addColumn<QString>("command");
+    QTest::addColumn<int>("expected_tab_count");
+    QTest::addColumn<int>("expected_current_tab");
+
+    QTest::newRow("next tab on ':tabnext'") << QString("tabnext") << 2 << 1;
+    QTest::newRow("next tab on ':tabn'") << QString("tabn") << 2 << 1;
+    QTest::newRow("go to tab on ':buffer 2'") << QString("buffer 2") << 2 << 1;
+    QTest::newRow("close tab on ':tabclose'") << QString("tabclose") << 1 << 0;
+    QTest::newRow("ignore unknown command") << QString("nosuchcommand") << 2 << 0;
+}
+
+void VimPluginTests::RunCommandsFromCommandLine()
+{
+    QFETCH(QString, command);
+    QFETCH(int, expected_tab_count);
+    QFETCH(int, expected_current_tab);
+
+    TabWidget* tab_widget = m_browser_window->tabWidget();
+    tab_widget->addView(QUrl::fromLocalFile(TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    tab_widget->setCurrentIndex(0);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+
+    QTest::keyClick(m_browser_window->weView()->focusProxy(), ':');
+    const VimCommandLine *command_line =
+        m_vim_plugin->vimEngine().commandLine();
+    QTRY_VERIFY(command_line && command_line->isVisible());
+
+    QTest::keyClicks(QApplication::focusWidget(), command);
+    QCOMPARE(command_line->text(), command);
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+
+    QTRY_COMPARE(tab_widget->normalTabsCount(), expected_tab_count);
+    QTRY_COMPARE(tab_widget->currentIndex(), expected_current_tab);
+}
+
+void VimPluginTests::DiscardBackgroundTabsAndRestoreOnActivation()
+{
+    const QUrl url_test_page = QUrl::fromLocalFile(TEST_PAGE_FILEPATH);
+    TabWidget* tab_widget = m_browser_window->tabWidget();
+
+    tab_widget->addView(url_test_page, Qz::NT_CleanSelectedTabAtTheEnd);
+    tab_widget->addView(url_test_page, Qz::NT_CleanSelectedTabAtTheEnd);
+    tab_widget->addView(url_test_page, Qz::NT_CleanSelectedTabAtTheEnd);
+    tab_widget->setCurrentIndex(0);
+    QTRY_COMPARE(tab_widget->count(), 4);
+    QTRY_COMPARE(m_browser_window->weView(3)->url(), url_test_page);
+    /* Pinning moves the tab first: 0 pinned, 1 current, 2 and 3 normal. */
+    tab_widget->webTab(3)->togglePinned();
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 3);
+    QVERIFY(tab_widget->webTab(0)->isPinned());
+    tab_widget->setCurrentIndex(1);
+    QTRY_COMPARE(tab_widget->currentIndex(), 1);
+    QPointer<WebPage> pinned_page = m_browser_window->weView(0)->page();
+    QPointer<WebPage> discarded_page = m_browser_window->weView(3)->page();
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().tabDiscarder(),
+            SIGNAL(discarded(int, qint64)));
+    QTest::keyClick(m_browser_window->weView()->focusProxy(), ':');
+    QTest::keyClicks(QApplication::focusWidget(), "discardall");
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toInt(), 2);
+    QCOMPARE(tab_widget->count(), 4);
+    /* The page is gone, the tab still knows what it showed. */
+    QVERIFY(!discarded_page);
+    QTRY_COMPARE(tab_widget->webTab(3)->url(), url_test_page);
+    QTRY_COMPARE(tab_widget->webTab(3)->title(),
+            tab_widget->webTab(1)->title());
+    QVERIFY(m_vim_plugin->vimEngine().tabDiscarder()->isDiscarded(
+                tab_widget->webTab(3)));
+
+    /* Pinned tabs keep their page. */
+    QVERIFY(pinned_page);
+    QVERIFY(!m_vim_plugin->vimEngine().tabDiscarder()->isDiscarded(
+                tab_widget->webTab(0)));
+
+    tab_widget->setCurrentIndex(3);
+    QTRY_COMPARE(tab_widget->currentIndex(), 3);
+    QString text;
+    for (int i = 0; i < 100 && !text.contains("test page 2"); ++i) {
+        m_browser_window->weView(3)->page()->runJavaScript(
+                "document.body ? document.body.innerText : ''",
+                [&text] (const QVariant &res) { text = res.toString(); });
+        QTest::qWait(50);
+    }
+    QVERIFY(text.contains("test page 2"));
+    QCOMPARE(m_browser_window->weView(3)->url(), url_test_page);
+    QVERIFY(!m_vim_plugin->vimEngine().tabDiscarder()->isDiscarded(
+                tab_widget->webTab(3)));
+}
+
+void VimPluginTests::RestoreScrollPositionOnReload()
+{
+    const WebView *web_view = m_browser_window->weView();
+
+    setPagePosition(1000, 2000);
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollMemory(),
+            SIGNAL(restored(WebPage*, QPointF)));
+    QTest::keyClick(web_view->focusProxy(), 'r');
+    QTRY_COMPARE(spy.count(), 1);
+
+    QTRY_COMPARE(web_view->page()->scrollPosition().x(), qreal(1000));
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(2000));
+}
+
+void VimPluginTests::RestoreScrollPositionBeforeLoadFinishes()
+{
+    /* Narrower than the view, so it never scrolls sideways, and kept
+     * loading by an image that never arrives.
+     */
+    TestHttpServer server({{"/narrow", "<html><body style='margin:0'>"
+            "<div style='width:200px; height:5000px'></div>"
+            "<img src='/hang'></body></html>"}});
+    WebView *web_view = m_browser_window->weView();
+    web_view->load(server.url("/narrow"));
+    QTRY_VERIFY(web_view->page()->contentsSize().height() >= 5000);
+
+    setPagePosition(0, 2000);
+
+    QSignalSpy restored_spy(m_vim_plugin->vimEngine().scrollMemory(),
+            SIGNAL(restored(WebPage*, QPointF)));
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    QTest::keyClick(web_view->focusProxy(), 'r');
+    QTRY_COMPARE(restored_spy.count(), 1);
+    QCOMPARE(load_spy.count(), 0);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(2000));
+}
+
+void VimPluginTests::RestoreScrollPositionInNewDocumentOnly()
+{
+    /* A log that keeps growing, and takes a second to be served again. */
+    TestHttpServer server({{"/slow/log", "<html><body style='margin:0'>"
+            "<div style='height:5000px'></div><script>"
+            "setInterval(function() {"
+            "    var row = document.createElement('div');"
+            "    row.style.height = '20px';"
+            "    document.body.appendChild(row);"
+            "}, 50);"
+            "</script></body></html>"}});
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->load(server.url("/slow/log"));
+    QTRY_COMPARE_WITH_TIMEOUT(load_spy.count(), 1, 5000);
+
+    setPagePosition(0, 2000);
+
+    /* The page being left grows while the reload waits for the server,
+     * the position must not be spent on it.
+     */
+    QSignalSpy restored_spy(m_vim_plugin->vimEngine().scrollMemory(),
+            SIGNAL(restored(WebPage*, QPointF)));
+    load_spy.clear();
+    QTest::keyClick(web_view->focusProxy(), 'r');
+    QTest::qWait(500);
+    QCOMPARE(restored_spy.count(), 0);
+
+    QTRY_COMPARE_WITH_TIMEOUT(load_spy.count(), 1, 5000);
+    QTRY_COMPARE(restored_spy.count(), 1);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(2000));
+}
+
+void VimPluginTests::RestoreScrollPositionOnBackForward()
+{
+    WebView *web_view = m_browser_window->weView();
+
+    setPagePosition(100, 3000);
+
+    QSignalSpy loadSpy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->load(QUrl::fromLocalFile(TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(loadSpy.count(), 1);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(0));
+
+    QTest::keyClick(web_view->focusProxy(), ':');
+    QTest::keyClicks(QApplication::focusWidget(), "back");
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+    QTRY_COMPARE(loadSpy.count(), 2);
+
+    QTRY_COMPARE(web_view->page()->scrollPosition().x(), qreal(100));
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(3000));
+}
+
+void VimPluginTests::JumpToLocalMark()
+{
+    const WebView *web_view = m_browser_window->weView();
+
+    setPagePosition(1000, 1000);
+    QTest::keyClicks(web_view->focusProxy(), "ma");
+
+    setPagePosition(0, 3000);
+    QTest::keyClicks(web_view->focusProxy(), "`a");
+    QTRY_COMPARE(web_view->page()->scrollPosition().x(), qreal(1000));
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(1000));
+
+    QTest::keyClicks(web_view->focusProxy(), "''");
+    QTRY_COMPARE(web_view->page()->scrollPosition().x(), qreal(0));
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(3000));
+}
+
+void VimPluginTests::JumpBackAndForthWithCtrlOAndCtrlI()
+{
+    const WebView *web_view = m_browser_window->weView();
+
+    setPagePosition(100, 100);
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(web_view->focusProxy(), 'G');
+    QTRY_COMPARE(spy.count(), VimEngine::numSteps());
+    QTRY_VERIFY(web_view->page()->scrollPosition().y() > 100);
+    const qreal bottom_y = web_view->page()->scrollPosition().y();
+    QCOMPARE(m_vim_plugin->vimEngine().marks()->jumpCount(), 1);
+
+    QTest::keyClick(web_view->focusProxy(), Qt::Key_O, Qt::ControlModifier);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(100));
+
+    QTest::keyClick(web_view->focusProxy(), Qt::Key_I, Qt::ControlModifier);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), bottom_y);
+}
+
+void VimPluginTests::StoreGlobalMarksInSettingsPath()
+{
+    const WebView *web_view = m_browser_window->weView();
+
+    setPagePosition(200, 300);
+    QTest::keyClicks(web_view->focusProxy(), "mQ");
+
+    QFile marks_file(m_vim_plugin->vimEngine().marks()->globalMarksFilePath());
+    QVERIFY(marks_file.exists());
+    QVERIFY(marks_file.open(QIODevice::ReadOnly));
+    QVERIFY(marks_file.readAll().contains(web_view->url().toEncoded()));
+
+    /* Global marks jump across documents. */
+    QSignalSpy loadSpy(web_view->page(), SIGNAL(loadFinished(bool)));
+    m_browser_window->weView()->load(QUrl::fromLocalFile(TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(loadSpy.count(), 1);
+
+    QTest::keyClicks(web_view->focusProxy(), "`Q");
+    QTRY_COMPARE(web_view->url(), QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(web_view->page()->scrollPosition().x(), qreal(200));
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(300));
+}
+
+void VimPluginTests::ReloadKeymapWhenConfigFileChanges()
+{
+    const WebView *web_view = m_browser_window->weView();
+    const VimConfigLoader *loader = m_vim_plugin->vimEngine().configLoader();
+    QSignalSpy config_spy(loader, SIGNAL(configChanged()));
+
+    QFile config_file(loader->filePath());
+    QVERIFY(config_file.open(QIODevice::WriteOnly | QIODevice::Text));
+    config_file.write("\" Scroll down with 'n' in bigger steps\n"
+                      "map n scrollDown\n"
+                      "unmap j\n"
+                      "set scrollsteps=3\n");
+    config_file.close();
+    QTRY_VERIFY(config_spy.count() >= 1);
+    QVERIFY(loader->errors().isEmpty());
+    m_vim_plugin->init();
+
+    setPagePosition(1000, 1000);
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTest::keyClick(web_view->focusProxy(), 'n');
+    QTRY_COMPARE(spy.count(), 3);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(),
+            qreal(1000 + 3 * VimEngine::stepSize()));
+
+    config_spy.clear();
+    QVERIFY(config_file.remove());
+    QTRY_VERIFY(config_spy.count() >= 1);
+    QCOMPARE(m_vim_plugin->vimEngine().config()->numScrollSteps(),
+            VimEngine::numSteps());
+}
+
+void VimPluginTests::SetOptionFromCommandLine()
+{
+    const WebView *web_view = m_browser_window->weView();
+
+    setPagePosition(1000, 1000);
+
+    QTest::keyClick(web_view->focusProxy(), ':');
+    QTest::keyClicks(QApplication::focusWidget(), "set scrollsteps=2");
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+    QCOMPARE(m_vim_plugin->vimEngine().config()->numScrollSteps(), 2);
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), 2);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(),
+            qreal(1000 + 2 * VimEngine::stepSize()));
+}
+
+void VimPluginTests::KeepQuotesInMappedCommands()
+{
+    QStringList errors;
+    const VimConfigPtr config = VimConfig::compile(
+            "map x :tabsearch \"foo bar\"\n"
+            "map n scrollDown   \" trailing comment\n", &errors);
+    QVERIFY(errors.isEmpty());
+
+    const VimConfig::Action search = config->action("x");
+    QCOMPARE(search.type, VimConfig::RunCommand);
+    QCOMPARE(search.command, QString("tabsearch \"foo bar\""));
+    QCOMPARE(config->action("n").type, VimConfig::ScrollDown);
+}
+
+void VimPluginTests::UrlMatcherMatchesExclusionRules()
+{
+    VimUrlMatcher matcher;
+    for (int i = 0; i < 500; ++i)
+        matcher.addRule(QString("https://site%1.example.com/*").arg(i), "");
+    matcher.addRule("https://mail.google.com/*", "");
+    matcher.addRule("*://docs.google.com/*", "jk");
+    matcher.addRule("*.wikipedia.org/wiki/*", "");
+    matcher.addRule("http://localhost:8080/*", "");
+    matcher.addRule("https://user@Intranet.Example.org/*", "");
+    matcher.addRule("*://*.Example.net/*", "");
+    matcher.finalize();
+
+    QCOMPARE(matcher.ruleCount(), 506);
+    QVERIFY(matcher.match(QUrl("https://mail.google.com/mail/u/0/")).disabled);
+    QVERIFY(matcher.match(QUrl("https://site499.example.com/a")).disabled);
+    QVERIFY(!matcher.match(QUrl("https://site500.example.com/a")).disabled);
+    QVERIFY(!matcher.match(QUrl("http://mail.google.com/")).disabled);
+    QVERIFY(matcher.match(QUrl("https://en.wikipedia.org/wiki/Vim")).disabled);
+
+    /* Ports, user info and upper case hosts. */
+    QVERIFY(matcher.match(QUrl("http://localhost:8080/log")).disabled);
+    QVERIFY(!matcher.match(QUrl("http://localhost:9090/log")).disabled);
+    QVERIFY(matcher.match(
+                QUrl("https://user@intranet.example.org/wiki")).disabled);
+    QVERIFY(matcher.match(QUrl("https://WWW.EXAMPLE.NET/")).disabled);
+
+    const VimUrlMatcher::Verdict docs =
+        matcher.match(QUrl("https://docs.google.com/document/d/1"));
+    QVERIFY(!docs.disabled);
+    QCOMPARE(docs.pass_keys, QString("jk"));
+}
+
+void VimPluginTests::IgnoreKeysOnExcludedPages_data()
+{
+    QTest::addColumn<QString>("rule");
+    QTest::addColumn<int>("expected_j_steps");
+    QTest::addColumn<int>("expected_k_steps");
+
+    QTest::newRow("disable plugin on excluded page")
+        << QString("exclude file://*/" BIG_TEST_PAGE) << 0 << 0;
+    QTest::newRow("pass 'j' to the page")
+        << QString("exclude file://*/" BIG_TEST_PAGE " j")
+        << 0 << VimEngine::numSteps();
+    QTest::newRow("keep plugin on other pages")
+        << QString("exclude file://*/" TEST_PAGE)
+        << VimEngine::numSteps() << VimEngine::numSteps();
+}
+
+void VimPluginTests::IgnoreKeysOnExcludedPages()
+{
+    QFETCH(QString, rule);
+    QFETCH(int, expected_j_steps);
+    QFETCH(int, expected_k_steps);
+
+    const WebView *web_view = m_browser_window->weView();
+    const VimConfigLoader *loader = m_vim_plugin->vimEngine().configLoader();
+    QSignalSpy config_spy(loader, SIGNAL(configChanged()));
+
+    QFile config_file(loader->filePath());
+    QVERIFY(config_file.open(QIODevice::WriteOnly | QIODevice::Text));
+    config_file.write(rule.toUtf8());
+    config_file.close();
+    QTRY_VERIFY(config_spy.count() >= 1);
+    QCOMPARE(m_vim_plugin->vimEngine().config()->exclusionRuleCount(), 1);
+
+    setPagePosition(1000, 1000);
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), expected_j_steps);
+
+    spy.clear();
+    QTest::keyClick(web_view->focusProxy(), 'k');
+    QTRY_COMPARE(spy.count(), expected_k_steps);
+
+    config_spy.clear();
+    QVERIFY(config_file.remove());
+    QTRY_VERIFY(config_spy.count() >= 1);
+}
+
+void VimPluginTests::IgnoreFirstKeyOnExcludedPage()
+{
+    /* A browser just started: its engine has seen no key and its config
+     * is still being compiled.
+     */
+    QTemporaryDir settings_dir;
+    QVERIFY(settings_dir.isValid());
+    QFile config_file(QDir(settings_dir.path()).filePath("vimplugin.vimrc"));
+    QVERIFY(config_file.open(QIODevice::WriteOnly | QIODevice::Text));
+    config_file.write("exclude file://*/" BIG_TEST_PAGE);
+    config_file.close();
+
+    VimEngine engine;
+    QSignalSpy config_spy(engine.configLoader(), SIGNAL(configChanged()));
+    engine.setSettingsPath(settings_dir.path());
+
+    WebPage *page = m_browser_window->weView()->page();
+    QVERIFY(engine.isExcluded(page));
+
+    QTRY_COMPARE(config_spy.count(), 1);
+    QCOMPARE(engine.config()->exclusionRuleCount(), 1);
+    QVERIFY(engine.isExcluded(page));
+
+    m_browser_window->weView()->load(QUrl::fromLocalFile(TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(page->url(), QUrl::fromLocalFile(TEST_PAGE_FILEPATH));
+    QVERIFY(!engine.isExcluded(page));
+}
+
+void VimPluginTests::ScrollInnerContainerWhenDocumentDoesNotScroll()
+{
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->load(QUrl::fromLocalFile(INNER_SCROLLER_TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), VimEngine::numSteps());
+    QTest::keyClick(web_view->focusProxy(), 'l');
+    QTRY_COMPARE(spy.count(), 2 * VimEngine::numSteps());
+
+    QVariant scroller_pos;
+    web_view->page()->runJavaScript(
+            "var s = document.getElementById('scroller');"
+            "[s.scrollLeft, s.scrollTop];",
+            [&scroller_pos] (const QVariant &res) { scroller_pos = res; });
+    QTRY_VERIFY(scroller_pos.isValid());
+    QCOMPARE(scroller_pos.toList().at(0).toInt(),
+            VimEngine::scrollSizeWithHJKL());
+    QCOMPARE(scroller_pos.toList().at(1).toInt(),
+            VimEngine::scrollSizeWithHJKL());
+    QCOMPARE(web_view->page()->scrollPosition(), QPointF(0, 0));
+
+    /* Replacing the container must not leave the helper with a stale
+     * target.
+     */
+    web_view->page()->runJavaScript(
+            "var old = document.getElementById('scroller');"
+            "var copy = old.cloneNode(true);"
+            "old.parentNode.replaceChild(copy, old);");
+
+    spy.clear();
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), VimEngine::numSteps());
+
+    scroller_pos = QVariant();
+    web_view->page()->runJavaScript(
+            "document.getElementById('scroller').scrollTop;",
+            [&scroller_pos] (const QVariant &res) { scroller_pos = res; });
+    QTRY_VERIFY(scroller_pos.isValid());
+    QCOMPARE(scroller_pos.toInt(), VimEngine::scrollSizeWithHJKL());
+}
+
+void VimPluginTests::FollowNextAndPreviousPageLinks()
+{
+    /* One page per way of finding the link: rel attribute, english text
+     * and localized text.
+     */
+    TestHttpServer server({
+        {"/1", "<html><head><link rel='next' href='/2'></head>"
+               "<body>Page 1</body></html>"},
+        {"/2", "<html><body><a rel='prev' href='/1'>first</a>"
+               "<a href='/help'>Help</a> <a href='/3'>Next \xe2\x80\xba</a>"
+               "</body></html>"},
+        {"/3", "<html><body><a href='/2'>\xc2\xab Anterior</a>"
+               "</body></html>"},
+        {"/4", "<html><body><a href='/5'>Next</a></body></html>"}
+    });
+    QVERIFY(server.isListening());
+
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->load(server.url("/1"));
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    QTest::keyClicks(web_view->focusProxy(), "]]");
+    QTRY_COMPARE(web_view->url(), server.url("/2"));
+
+    /* The page ']]' would go to next is fetched before it is asked for. */
+    QTRY_VERIFY(server.requestedPaths().contains("/3"));
+    QVERIFY(!server.requestedPaths().contains("/help"));
+
+    QTest::keyClicks(web_view->focusProxy(), "]]");
+    QTRY_COMPARE(web_view->url(), server.url("/3"));
+
+    QTest::keyClicks(web_view->focusProxy(), "[[");
+    QTRY_COMPARE(web_view->url(), server.url("/2"));
+
+    load_spy.clear();
+    QTest::keyClicks(web_view->focusProxy(), "[[");
+    QTRY_COMPARE(web_view->url(), server.url("/1"));
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    /* Pages the user opens on their own prefetch nothing. */
+    load_spy.clear();
+    web_view->load(server.url("/4"));
+    QTRY_COMPARE(load_spy.count(), 1);
+    QTest::qWait(500);
+    QVERIFY(!server.requestedPaths().contains("/5"));
+}
+
+void VimPluginTests::ReplayScrollMacroWithoutAnimation()
+{
+    const WebView *web_view = m_browser_window->weView();
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+
+    QTest::keyClicks(web_view->focusProxy(), "qa");
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), VimEngine::numSteps());
+    QTest::keyClick(web_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), 2 * VimEngine::numSteps());
+    QTest::keyClick(web_view->focusProxy(), 'q');
+
+    QCOMPARE(m_vim_plugin->vimEngine().macros()->macro('a').size(), 2);
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(),
+            qreal(2 * VimEngine::scrollSizeWithHJKL()));
+
+    /* Forty scrolls coalesced into a single jump, no timer step at all. */
+    spy.clear();
+    QTest::keyClicks(web_view->focusProxy(), "20@a");
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(),
+            qreal(42 * VimEngine::scrollSizeWithHJKL()));
+    QCOMPARE(spy.count(), 0);
+
+    QTest::keyClicks(web_view->focusProxy(), "@@");
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(),
+            qreal(44 * VimEngine::scrollSizeWithHJKL()));
+    QCOMPARE(spy.count(), 0);
+}
+
+void VimPluginTests::ReplayTabMacroAsSingleSwitch()
+{
+    TabWidget *tab_widget = m_browser_window->tabWidget();
+    tab_widget->addView(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    tab_widget->addView(QUrl::fromLocalFile(TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    tab_widget->setCurrentIndex(0);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 3);
+
+    QTest::keyClicks(m_browser_window->weView()->focusProxy(), "qbKq");
+    QTRY_COMPARE(tab_widget->currentIndex(), 1);
+
+    QSignalSpy spy(tab_widget, SIGNAL(currentChanged(int)));
+    QTest::keyClicks(m_browser_window->weView()->focusProxy(), "4@b");
+    QTRY_COMPARE(tab_widget->currentIndex(), 2);
+    QCOMPARE(spy.count(), 1);
+}
+
+void VimPluginTests::StopSelfRecursiveMacro()
+{
+    const WebView *web_view = m_browser_window->weView();
+
+    /* Register 'a' is empty while it records, the '@a' is kept as is. */
+    QTest::keyClicks(web_view->focusProxy(), "qaj@aq");
+    QCOMPARE(m_vim_plugin->vimEngine().macros()->macro('a').size(), 2);
+
+    setPagePosition(0, 0);
+    QTest::keyClicks(web_view->focusProxy(), "@a");
+    const VimCommandLine *command_line =
+        m_vim_plugin->vimEngine().commandLine();
+    QVERIFY(command_line);
+    QCOMPARE(command_line->text(), QString("E169: Command too recursive"));
+    QTRY_VERIFY(web_view->page()->scrollPosition().y() > 0);
+
+    /* Still listening. */
+    QTest::keyClick(web_view->focusProxy(), 'G');
+    QTest::keyClick(web_view->focusProxy(), 'g');
+    QTest::keyClick(web_view->focusProxy(), 'g');
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(0));
+}
+
+void VimPluginTests::PickTabFromThumbnails()
+{
+    TabWidget *tab_widget = m_browser_window->tabWidget();
+    const VimThumbnailCache *thumbnails =
+        m_vim_plugin->vimEngine().thumbnails();
+
+    /* Any key makes the engine follow this window's tabs. */
+    QTest::keyClick(m_browser_window->weView()->focusProxy(), Qt::Key_Escape);
+
+    WebTab *first_tab = tab_widget->webTab(0);
+    tab_widget->addView(QUrl::fromLocalFile(TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+    QTRY_COMPARE(tab_widget->currentIndex(), 1);
+
+    /* Leaving a tab stores its preview, small and compressed. */
+    QTRY_VERIFY(thumbnails->contains(first_tab));
+    const QImage preview = thumbnails->thumbnail(first_tab);
+    QVERIFY(!preview.isNull());
+    QVERIFY(preview.width() <= VimThumbnailCache::thumbnailSize().width());
+    QVERIFY(preview.height() <= VimThumbnailCache::thumbnailSize().height());
+    QVERIFY(thumbnails->totalCost() <= thumbnails->budget());
+
+    /* Grabbed before the tab was hidden: its text, not a blank frame. */
+    bool blank = true;
+    for (int y = 0; blank && y < preview.height(); ++y) {
+        for (int x = 0; blank && x < preview.width(); ++x)
+            blank = preview.pixel(x, y) == preview.pixel(0, 0);
+    }
+    QVERIFY(!blank);
+
+    QTest::keyClick(m_browser_window->weView()->focusProxy(), 'T');
+    QTRY_VERIFY(m_vim_plugin->vimEngine().tabPicker());
+    QTRY_VERIFY(m_vim_plugin->vimEngine().tabPicker()->isVisible());
+
+    QTest::keyClick(QApplication::focusWidget(), 'h');
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+    QTRY_COMPARE(tab_widget->currentIndex(), 0);
+    QTRY_VERIFY(!m_vim_plugin->vimEngine().tabPicker());
+    QTRY_VERIFY(thumbnails->contains(tab_widget->webTab(1)));
+}
+
+void VimPluginTests::YankSelectionFromCaretAndVisualMode_data()
+{
+    QTest::addColumn<QString>("keys");
+    QTest::addColumn<QString>("expected_text");
+
+    QTest::newRow("visual from the first word") << "vllllly" << "alpha ";
+    QTest::newRow("caret then visual") << "c6lv3ly" << "beta";
+    QTest::newRow("line end") << "v$y" << "alpha beta gamma";
+    QTest::newRow("line start then word") << "c$0wv3ly" << "beta";
+}
+
+void VimPluginTests::YankSelectionFromCaretAndVisualMode()
+{
+    QFETCH(QString, keys);
+    QFETCH(QString, expected_text);
+
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->page()->setHtml("<p>alpha beta gamma</p>");
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    QApplication::clipboard()->clear();
+    const VimSelection *selection = m_vim_plugin->vimEngine().selection();
+    for (const QChar &key : keys) {
+        QTest::keyClick(web_view->focusProxy(), key.toLatin1());
+        if ('y' != key)
+            QVERIFY(VimSelection::Off != selection->mode());
+    }
+
+    QCOMPARE(selection->mode(), VimSelection::Off);
+    QTRY_COMPARE(QApplication::clipboard()->text(), expected_text);
+}
+
+void VimPluginTests::ApplyZoomChangesOncePerFrame()
+{
+    WebView *web_view = m_browser_window->weView();
+    const int base_level = web_view->zoomLevel();
+    QSignalSpy spy(m_vim_plugin->vimEngine().zoomTimer(), SIGNAL(timeout()));
+
+    /* Keys sent in a row all land in the same frame. */
+    QTest::keyClicks(web_view->focusProxy(), "zizizi");
+    QCOMPARE(web_view->zoomLevel(), base_level);
+    QTRY_COMPARE(web_view->zoomLevel(), base_level + 3);
+    QCOMPARE(spy.count(), 1);
+
+    QTest::keyClicks(web_view->focusProxy(), "2zo");
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(web_view->zoomLevel(), base_level + 1);
+
+    QTest::keyClicks(web_view->focusProxy(), "zizoz0zi");
+    QTRY_COMPARE(spy.count(), 3);
+    QCOMPARE(web_view->zoomLevel(), base_level + 1);
+
+    QTest::keyClicks(web_view->focusProxy(), "z0");
+    QTRY_COMPARE(spy.count(), 4);
+    QCOMPARE(web_view->zoomLevel(), base_level);
+}
+
+void VimPluginTests::SearchTextAcrossTabs()
+{
+    TabWidget *tab_widget = m_browser_window->tabWidget();
+    const VimTextIndex *text_index = m_vim_plugin->vimEngine().textIndex();
+
+    tab_widget->addView(QUrl::fromLocalFile(TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+    WebTab *search_tab = tab_widget->webTab(1);
+    tab_widget->setCurrentIndex(0);
+    QTRY_COMPARE(tab_widget->currentIndex(), 0);
+    setPagePosition(0, 1000);
+
+    /* Text is read in the background once the page loaded. */
+    QTRY_VERIFY_WITH_TIMEOUT(text_index->contains(search_tab), 10000);
+    QVERIFY(text_index->compressedBytes() > 0);
+
+    runCommand("tabsearch TEST PAGE 2");
+    QTRY_VERIFY(m_vim_plugin->vimEngine().searchResults());
+    QTRY_COMPARE(m_vim_plugin->vimEngine().searchResults()->count(), 1);
+
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+    QTRY_COMPARE(tab_widget->currentIndex(), 1);
+    QTRY_VERIFY(!m_vim_plugin->vimEngine().searchResults());
+
+    /* The jump went to the jumplist, Ctrl-O brings back where it started. */
+    WebView *web_view = m_browser_window->weView();
+    QTest::keyClick(web_view->focusProxy(), Qt::Key_O, Qt::ControlModifier);
+    QTRY_COMPARE(web_view->url(), QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(web_view->page()->scrollPosition().y(), qreal(1000));
+
+    runCommand("tabsearch no such text");
+    QTRY_VERIFY(!m_vim_plugin->vimEngine().searchResults());
+}
+
+void VimPluginTests::FollowBottomOfGrowingPage()
+{
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    /* A feed adding 3000px, three times, whenever the bottom gets near. */
+    web_view->page()->setHtml(
+        "<body style='margin: 0'><div id='feed' style='height: 3000px'></div>"
+        "<script>"
+        "var added = 0, pending = false;"
+        "window.addEventListener('scroll', function() {"
+        "    var feed = document.getElementById('feed');"
+        "    if (pending || added >= 3 || window.scrollY + window.innerHeight"
+        "            < document.body.scrollHeight - 200)"
+        "        return;"
+        "    pending = true;"
+        "    setTimeout(function() {"
+        "        feed.style.height = (feed.offsetHeight + 3000) + 'px';"
+        "        ++added;"
+        "        pending = false;"
+        "    }, 100);"
+        "});"
+        "</script></body>");
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    auto distance_to_bottom = [web_view] () {
+        QVariant res;
+        web_view->page()->runJavaScript(
+                "document.body.scrollHeight - window.scrollY"
+                " - window.innerHeight",
+                [&res] (const QVariant &value) { res = value; });
+        for (int i = 0; i < 100 && !res.isValid(); ++i)
+            QTest::qWait(10);
+        return res.isValid() ? res.toInt() : -1;
+    };
+
+    QTest::keyClick(web_view->focusProxy(), 'G');
+    QVERIFY(m_vim_plugin->vimEngine().isFollowingBottom());
+
+    QVariant height;
+    QTRY_VERIFY_WITH_TIMEOUT(!m_vim_plugin->vimEngine().isFollowingBottom(),
+            15000);
+    web_view->page()->runJavaScript("document.body.scrollHeight",
+            [&height] (const QVariant &value) { height = value; });
+    QTRY_VERIFY(height.isValid());
+    QCOMPARE(height.toInt(), 12000);
+    QCOMPARE(distance_to_bottom(), 0);
+
+    /* Any key stops following. */
+    QTest::keyClick(web_view->focusProxy(), 'G');
+    QVERIFY(m_vim_plugin->vimEngine().isFollowingBottom());
+    QTest::keyClick(web_view->focusProxy(), 'k');
+    QVERIFY(!m_vim_plugin->vimEngine().isFollowingBottom());
+}
+
+void VimPluginTests::JumpThroughPageStructure()
+{
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->load(QUrl::fromLocalFile(OUTLINE_TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    QVariant tops;
+    web_view->page()->runJavaScript(
+            "['intro', 'install', 'usage'].map(function(id) {"
+            "    return document.getElementById(id).offsetTop; });",
+            [&tops] (const QVariant &res) { tops = res; });
+    QTRY_VERIFY(tops.isValid());
+    const int intro_top = tops.toList().at(0).toInt();
+    const int install_top = tops.toList().at(1).toInt();
+    const int usage_top = tops.toList().at(2).toInt();
+
+    QWidget *input = web_view->focusProxy();
+    QTest::keyClicks(input, "]h");
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()), intro_top);
+    QTest::keyClicks(input, "]h");
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()), install_top);
+    /* The hidden heading in between is skipped. */
+    QTest::keyClicks(input, "]h");
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()), usage_top);
+    QTest::keyClicks(input, "2[h");
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()), intro_top);
+
+    /* Headings added later are found without looking the page over
+     * again.
+     */
+    QVariant moved_tops;
+    web_view->page()->runJavaScript(
+            "var h = document.createElement('h2');"
+            "h.textContent = 'Added';"
+            "var install = document.getElementById('install');"
+            "install.before(h);"
+            "[h.offsetTop, install.offsetTop];",
+            [&moved_tops] (const QVariant &res) { moved_tops = res; });
+    QTRY_VERIFY(moved_tops.isValid());
+    const int added_top = moved_tops.toList().at(0).toInt();
+    const int moved_install_top = moved_tops.toList().at(1).toInt();
+    QTest::keyClicks(input, "]h");
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()), added_top);
+
+    QTest::keyClicks(input, "gg");
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()), 0);
+    QTest::keyClicks(input, "gO");
+    QTRY_VERIFY(m_vim_plugin->vimEngine().outlinePicker());
+    const VimOutlinePicker *picker = m_vim_plugin->vimEngine().outlinePicker();
+    QTRY_VERIFY(picker->isVisible());
+    /* Navigation and main landmarks, then the four shown headings. */
+    QCOMPARE(picker->count(), 6);
+    QCOMPARE(picker->item(0)->text(), QString("[navigation: Contents]"));
+    QCOMPARE(picker->item(3)->text(), QString("  Added"));
+
+    QTest::keyClicks(QApplication::focusWidget(), "jjjj");
+    QTest::keyClick(QApplication::focusWidget(), Qt::Key_Return);
+    QTRY_COMPARE(int(web_view->page()->scrollPosition().y()),
+            moved_install_top);
+}
+
+void VimPluginTests::ScrollBoundPagesTogether()
+{
+    TabWidget *tab_widget = m_browser_window->tabWidget();
+    WebView *first_view = m_browser_window->weView();
+    QSignalSpy load_spy(first_view->page(), SIGNAL(loadFinished(bool)));
+    first_view->load(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(load_spy.count(), 1);
+    runCommand("scrollbind");
+
+    tab_widget->addView(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH),
+            Qz::NT_SelectedTabAtTheEnd);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+    WebView *second_view = m_browser_window->weView();
+    QVERIFY(second_view != first_view);
+    QTRY_VERIFY(!second_view->isLoading());
+    runCommand("scb");
+    QCOMPARE(m_vim_plugin->vimEngine().scrollBoundCount(), 2);
+
+    /* Same page and size on both sides: the same fraction is the same
+     * position.
+     */
+    QSignalSpy spy(m_vim_plugin->vimEngine().scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(second_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), VimEngine::numSteps());
+    QTRY_COMPARE(second_view->page()->scrollPosition().y(),
+            qreal(VimEngine::scrollSizeWithHJKL()));
+
+    auto scroll_y = [] (WebView *view) {
+        QVariant res;
+        view->page()->runJavaScript("window.scrollY;",
+                [&res] (const QVariant &value) { res = value; });
+        for (int i = 0; i < 100 && !res.isValid(); ++i)
+            QTest::qWait(10);
+        return res.toInt();
+    };
+    QTRY_COMPARE(scroll_y(first_view), VimEngine::scrollSizeWithHJKL());
+
+    /* Unbound pages stay where they are. */
+    runCommand("scrollbind");
+    QCOMPARE(m_vim_plugin->vimEngine().scrollBoundCount(), 1);
+    QTest::keyClick(second_view->focusProxy(), 'j');
+    QTRY_COMPARE(spy.count(), 2 * VimEngine::numSteps());
+    QTRY_COMPARE(second_view->page()->scrollPosition().y(),
+            qreal(2 * VimEngine::scrollSizeWithHJKL()));
+    QCOMPARE(scroll_y(first_view), VimEngine::scrollSizeWithHJKL());
+}
+
+void VimPluginTests::ReduceScrollStepsWhenPageLags()
+{
+    const VimEngine &engine = m_vim_plugin->vimEngine();
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->load(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH));
+    QTRY_COMPARE(load_spy.count(), 1);
+    WebPage *page = web_view->page();
+    QCOMPARE(engine.scrollQuality(page).mode(), VimScrollQuality::Smooth);
+
+    /* A page busy most of the time paints steps many frames late. */
+    web_view->page()->runJavaScript(
+            "window.busy = setInterval(function() {"
+            "    var start = performance.now();"
+            "    while (performance.now() - start < 150) {}"
+            "}, 0);");
+
+    QWidget *input = web_view->focusProxy();
+    for (int i = 0; i < 20
+            && VimScrollQuality::Smooth == engine.scrollQuality(page).mode();
+            ++i) {
+        QTest::keyClick(input, 'j');
+        QTRY_VERIFY(!engine.scrollTimer()->isActive());
+    }
+    QVERIFY(VimScrollQuality::Smooth != engine.scrollQuality(page).mode());
+    QVERIFY(engine.scrollQuality(page).averageLag()
+            > 2 * VimEngine::stepsInterval());
+
+    /* Other pages keep their own figures. */
+    TabWidget *tab_widget = m_browser_window->tabWidget();
+    tab_widget->addView(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH),
+            Qz::NT_CleanNotSelectedTab);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+    WebPage *other_page = tab_widget->webTab(1)->webView()->page();
+    QCOMPARE(engine.scrollQuality(other_page).mode(),
+            VimScrollQuality::Smooth);
+    QVERIFY(engine.scrollQuality(other_page).summary()
+            != engine.scrollQuality(page).summary());
+
+    /* The first step is taken at once, the rest on the timer. */
+    QSignalSpy spy(engine.scrollTimer(), SIGNAL(timeout()));
+    QTest::keyClick(input, 'j');
+    QTRY_VERIFY(!engine.scrollTimer()->isActive());
+    QVERIFY(spy.count() < VimEngine::numSteps() - 1);
+
+    web_view->page()->runJavaScript("clearInterval(window.busy);");
+    for (int i = 0; i < 40
+            && VimScrollQuality::Smooth != engine.scrollQuality(page).mode();
+            ++i) {
+        QTest::keyClick(input, 'j');
+        QTRY_VERIFY(!engine.scrollTimer()->isActive());
+        QTest::qWait(50);
+    }
+    QCOMPARE(engine.scrollQuality(page).mode(), VimScrollQuality::Smooth);
+    QVERIFY(engine.scrollQuality(page).summary().startsWith("scroll smooth"));
+}
+
+void VimPluginTests::RecordAndReplaySession()
+{
+    const QString session_path =
+        QDir::temp().filePath("vimplugin_test_session.bin");
+    TabWidget *tab_widget = m_browser_window->tabWidget();
+
+    tab_widget->addView(QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH),
+            Qz::NT_CleanSelectedTabAtTheEnd);
+    QTRY_COMPARE(tab_widget->normalTabsCount(), 2);
+    tab_widget->setCurrentIndex(0);
+
+    runCommand("sessionrecord " + session_path);
+
+    auto send = [this] (QEvent::Type type, int key, const QString &text,
+            bool auto_repeat) {
+        QKeyEvent event(type, key, text.at(0).isUpper() ? Qt::ShiftModifier
+                                                        : Qt::NoModifier,
+                text, auto_repeat);
+        if (QEvent::KeyPress == type)
+            m_vim_plugin->keyPress(Qz::ON_WebView, m_browser_window->weView(),
+                    &event);
+        else
+            m_vim_plugin->keyRelease(Qz::ON_WebView,
+                    m_browser_window->weView(), &event);
+    };
+
+    /* 'j' held down, then a tab switch and a jump to the bottom. */
+    send(QEvent::KeyPress, Qt::Key_J, "j", false);
+    for (int i = 0; i < 5; ++i) {
+        QTest::qWait(30);
+        send(QEvent::KeyRelease, Qt::Key_J, "j", true);
+        send(QEvent::KeyPress, Qt::Key_J, "j", true);
+    }
+    send(QEvent::KeyRelease, Qt::Key_J, "j", false);
+    send(QEvent::KeyPress, Qt::Key_K, "K", false);
+    send(QEvent::KeyRelease, Qt::Key_K, "K", false);
+    QTRY_COMPARE(tab_widget->currentIndex(), 1);
+    send(QEvent::KeyPress, Qt::Key_G, "G", false);
+    send(QEvent::KeyRelease, Qt::Key_G, "G", false);
+
+    runCommand("sessionstop");
+
+    QFile session_file(session_path);
+    QVERIFY(session_file.open(QIODevice::ReadOnly));
+    QString error;
+    const QVector<VimSessionRecorder::Event> events =
+        VimSessionRecorder::read(&session_file, &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+
+    int key_events = 0;
+    int auto_repeats = 0;
+    int tab_events = 0;
+    int url_events = 0;
+    foreach (const VimSessionRecorder::Event &event, events) {
+        if (VimSessionRecorder::Tabs == event.type)
+            ++tab_events;
+        else if (VimSessionRecorder::Url == event.type)
+            ++url_events;
+        else
+            ++key_events;
+        if (event.auto_repeat)
+            ++auto_repeats;
+    }
+    QCOMPARE(auto_repeats, 10);
+    QCOMPARE(tab_events, 2);
+    QVERIFY(url_events >= 1);
+
+    /* Back where the recording started, four times faster. */
+    tab_widget->setCurrentIndex(0);
+    VimSessionReplay replay(m_vim_plugin, m_browser_window);
+    replay.setSpeed(4);
+    replay.setUrlMapper([] (const QUrl &) {
+        return QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH);
+    });
+    const VimSessionReplay::Report report = replay.run(events);
+
+    QCOMPARE(report.keys, key_events);
+    QCOMPARE(tab_widget->currentIndex(), 1);
+    QVERIFY(report.latency_median_us <= report.latency_max_us);
+    QVERIFY(!m_vim_plugin->vimEngine().scrollTimer()->isActive());
+
+    session_file.remove();
+}
+
+void VimPluginTests::ReplaySessionFromEnvironment()
+{
+    /* Replays a real session: VIMPLUGIN_SESSION=file.bin, optionally with
+     * VIMPLUGIN_SESSION_SPEED. Every page is replaced by the big test page.
+     */
+    const QString session_path = qgetenv("VIMPLUGIN_SESSION");
+    if (session_path.isEmpty())
+        QSKIP("VIMPLUGIN_SESSION not set");
+
+    QFile session_file(session_path);
+    QVERIFY(session_file.open(QIODevice::ReadOnly));
+    QString error;
+    const QVector<VimSessionRecorder::Event> events =
+        VimSessionRecorder::read(&session_file, &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+
+    bool speed_ok = false;
+    const double speed = qgetenv("VIMPLUGIN_SESSION_SPEED").toDouble(&speed_ok);
+
+    VimSessionReplay replay(m_vim_plugin, m_browser_window);
+    replay.setSpeed(speed_ok ? speed : 1);
+    replay.setUrlMapper([] (const QUrl &) {
+        return QUrl::fromLocalFile(BIG_TEST_PAGE_FILEPATH);
+    });
+    qDebug().noquote() << replay.run(events).toString();
+}
+
+void VimPluginTests::SkipFormFieldKeysWhenRecording()
+{
+    const QString session_path =
+        QDir::temp().filePath("vimplugin_test_form_session.bin");
+    WebView *web_view = m_browser_window->weView();
+    QSignalSpy load_spy(web_view->page(), SIGNAL(loadFinished(bool)));
+    web_view->page()->setHtml("<input id='password' type='password'>");
+    QTRY_COMPARE(load_spy.count(), 1);
+
+    runCommand("sessionrecord " + session_path);
+
+    auto type = [this, web_view] (int key, const QString &text) {
+        QKeyEvent press(QEvent::KeyPress, key, Qt::NoModifier, text);
+        m_vim_plugin->keyPress(Qz::ON_WebView, web_view, &press);
+        QKeyEvent release(QEvent::KeyRelease, key, Qt::NoModifier, text);
+        m_vim_plugin->keyRelease(Qz::ON_WebView, web_view, &release);
+    };
+
+    web_view->page()->runJavaScript(
+            "document.getElementById('password').focus();");
+    QTRY_VERIFY(web_view->focusProxy()->inputMethodQuery(
+                Qt::ImEnabled).toBool());
+    type(Qt::Key_S, "s");
+    type(Qt::Key_E, "e");
+
+    web_view->page()->runJavaScript("document.activeElement.blur();");
+    QTRY_VERIFY(!web_view->focusProxy()->inputMethodQuery(
+                Qt::ImEnabled).toBool());
+    type(Qt::Key_J, "j");
+
+    runCommand("sessionstop");
+
+    QFile session_file(session_path);
+    QVERIFY(session_file.open(QIODevice::ReadOnly));
+    QString error;
+    const QVector<VimSessionRecorder::Event> events =
+        VimSessionRecorder::read(&session_file, &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+
+    QString recorded;
+    foreach (const VimSessionRecorder::Event &event, events) {
+        if (VimSessionRecorder::KeyPress == event.type)
+            recorded += event.text;
+    }
+    /* ':' opened the command line that stopped the recording. */
+    QCOMPARE(recorded, QString("j:"));
+
+    session_file.remove();
+}
+
 /* Using "APPLESS" version because MainApplication is already a QApplication
  * and it was not coping well with QTEST_MAIN.
  */
@@ -0,0 +1,200 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#include "VimSessionReplay.h"
+#include "VimPlugin.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QKeyEvent>
+#include <QSignalSpy>
+#include <QTest>
+#include <QTimer>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "browserwindow.h"
+#include "tabbedwebview.h"
+#include "tabwidget.h"
+#include "webpage.h"
+
+const int VimSessionReplay::m_load_timeout = 5000;
+
+QString VimSessionReplay::Report::toString() const
+{
+    return QString("%1 events, %2 keys in %3 ms, %4 ms CPU\n"
+                   "key latency: median %5 us, p95 %6 us, max %7 us\n"
+                   "max lag behind the recording: %8 ms")
+        .arg(events).arg(keys).arg(wall_ms).arg(cpu_ms)
+        .arg(latency_median_us).arg(latency_p95_us).arg(latency_max_us)
+        .arg(max_lag_ms);
+}
+
+VimSessionReplay::VimSessionReplay(VimPlugin *plugin, BrowserWindow *window)
+    : m_plugin(plugin)
+    , m_window(window)
+    , m_speed(1)
+    , m_url_mapper([] (const QUrl &url) { return url; })
+{
+}
+
+void VimSessionReplay::setSpeed(double speed)
+{
+    m_speed = qMax(0.0, speed);
+}
+
+void VimSessionReplay::setUrlMapper(
+        const std::function<QUrl (const QUrl &)> &mapper)
+{
+    m_url_mapper = mapper;
+}
+
+VimSessionReplay::Report VimSessionReplay::run(
+        const QVector<VimSessionRecorder::Event> &events)
+{
+    Report report = {events.size(), 0, 0, 0, 0, 0, 0, 0};
+    QVector<qint64> latencies;
+
+    const qint64 cpu_before = cpuTimeMs();
+    QElapsedTimer clock;
+    clock.start();
+    /* Page loads take as long as they take here, the events after one
+     * keep their spacing instead of all being late.
+     */
+    qint64 load_time = 0;
+
+    foreach (const VimSessionRecorder::Event &event, events) {
+        if (m_speed > 0) {
+            const qint64 due = qint64(event.time_ms / m_speed) + load_time;
+            const qint64 wait = due - clock.elapsed();
+            if (wait > 0)
+                QTest::qWait(int(wait));
+            report.max_lag_ms = qMax(report.max_lag_ms, clock.elapsed() - due);
+        }
+
+        switch (event.type) {
+            case VimSessionRecorder::KeyPress:
+            case VimSessionRecorder::KeyRelease:
+                latencies << dispatchKey(event);
+                break;
+
+            case VimSessionRecorder::Url: {
+                QElapsedTimer load_clock;
+                load_clock.start();
+                loadUrl(m_url_mapper(event.url));
+                load_time += load_clock.elapsed();
+                break;
+            }
+
+            case VimSessionRecorder::Tabs:
+                setTabs(event.tab_count, event.current_tab);
+                break;
+        }
+    }
+
+    /* Animations started by the last keys are part of the session. */
+    const QTimer *scroll_timer = m_plugin->vimEngine().scrollTimer();
+    for (int i = 0; i < 500 && scroll_timer->isActive(); ++i)
+        QTest::qWait(10);
+
+    report.wall_ms = clock.elapsed();
+    report.cpu_ms = cpu_before < 0 ? -1 : cpuTimeMs() - cpu_before;
+    report.keys = latencies.size();
+    if (!latencies.isEmpty()) {
+        std::sort(latencies.begin(), latencies.end());
+        report.latency_median_us = latencies.at(latencies.size() / 2);
+        report.latency_p95_us = latencies.at(latencies.size() * 95 / 100);
+        report.latency_max_us = latencies.last();
+    }
+    return report;
+}
+
+void VimSessionReplay::loadUrl(const QUrl &url)
+{
+    TabbedWebView *view = m_window->weView();
+    if (!view || !url.isValid() || view->url() == url)
+        return;
+
+    QSignalSpy load_spy(view->page(), SIGNAL(loadFinished(bool)));
+    view->load(url);
+    load_spy.wait(m_load_timeout);
+}
+
+void VimSessionReplay::setTabs(int count, int current)
+{
+    TabWidget *tab_widget = m_window->tabWidget();
+    count = qMax(1, count);
+
+    while (tab_widget->count() < count) {
+        const int before = tab_widget->count();
+        tab_widget->addView(m_url_mapper(QUrl()),
+                Qz::NT_CleanSelectedTabAtTheEnd);
+        for (int i = 0; i < 100 && tab_widget->count() == before; ++i)
+            QTest::qWait(10);
+    }
+    while (tab_widget->count() > count) {
+        const int before = tab_widget->count();
+        tab_widget->requestCloseTab(tab_widget->count() - 1);
+        for (int i = 0; i < 100 && tab_widget->count() == before; ++i)
+            QTest::qWait(10);
+    }
+
+    if (current < tab_widget->count() && current != tab_widget->currentIndex())
+        tab_widget->setCurrentIndex(current);
+}
+
+qint64 VimSessionReplay::dispatchKey(const VimSessionRecorder::Event &event)
+{
+    TabbedWebView *view = m_window->weView();
+    if (!view)
+        return 0;
+
+    const bool press = VimSessionRecorder::KeyPress == event.type;
+    QKeyEvent key_event(press ? QEvent::KeyPress : QEvent::KeyRelease,
+            event.key, event.modifiers, event.text, event.auto_repeat);
+
+    QElapsedTimer latency;
+    latency.start();
+    if (press)
+        m_plugin->keyPress(Qz::ON_WebView, view, &key_event);
+    else
+        m_plugin->keyRelease(Qz::ON_WebView, view, &key_event);
+
+    /* A zero timer runs once what was already queued has been handled. */
+    QEventLoop loop;
+    QTimer::singleShot(0, &loop, SLOT(quit()));
+    loop.exec();
+    return latency.nsecsElapsed() / 1000;
+}
+
+qint64 VimSessionReplay::cpuTimeMs()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+        return -1;
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#else
+    return -1;
+#endif
+}
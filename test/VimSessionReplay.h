@@ -0,0 +1,81 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+#ifndef VIM_SESSION_REPLAY_H
+#define VIM_SESSION_REPLAY_H
+
+#include "VimSessionRecorder.h"
+
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+#include <functional>
+
+class BrowserWindow;
+class VimPlugin;
+
+/* Feeds a session recorded with ':sessionrecord' back into the plugin's
+ * key handlers, at the recorded pace or faster, and measures it.
+ *
+ * Recorded URLs go through a mapper, so sessions taken on the web replay
+ * against local test pages; tab records open, close and switch tabs to
+ * match. Key latency is the time from handing a key to the plugin until
+ * the event loop is idle again, which covers the work the key queues and
+ * not only the handler call. CPU time is the browser process' only:
+ * renderers are separate processes.
+ */
+class VimSessionReplay
+{
+    public:
+        struct Report {
+            int events;
+            int keys;
+            qint64 wall_ms;
+            qint64 cpu_ms;
+            qint64 latency_median_us;
+            qint64 latency_p95_us;
+            qint64 latency_max_us;
+            /* Worst delay of an event behind its recorded time. */
+            qint64 max_lag_ms;
+
+            QString toString() const;
+        };
+
+        VimSessionReplay(VimPlugin *plugin, BrowserWindow *window);
+
+        /* 1 is the recorded pace, 4 four times faster, 0 no waiting. */
+        void setSpeed(double speed);
+        void setUrlMapper(const std::function<QUrl (const QUrl &)> &mapper);
+
+        Report run(const QVector<VimSessionRecorder::Event> &events);
+
+    private:
+        void loadUrl(const QUrl &url);
+        void setTabs(int count, int current);
+        qint64 dispatchKey(const VimSessionRecorder::Event &event);
+        static qint64 cpuTimeMs();
+
+        static const int m_load_timeout;
+        VimPlugin *m_plugin;
+        BrowserWindow *m_window;
+        double m_speed;
+        std::function<QUrl (const QUrl &)> m_url_mapper;
+};
+
+#endif
@@ -0,0 +1,252 @@
+/* ============================================================
+* VimPlugin - Vim Plugin for QupZilla Web Broswer
+* Copyright (C) 2017  Jose Rios <joseriosneto@gmail.com>
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+* ============================================================ */
+
+/* Startup cost of the plugin.
+ *
+ * Starts QupZilla a few times with and without the plugin, each time in a
+ * fresh process and profile, and reports the median time until the first
+ * window is up, the browser process' resident memory at that point and the
+ * time the first key press takes (the plugin sets itself up on it).
+ *
+ *   $ ../build/VimPluginStartupBenchmark [--runs N]
+ *
+ * Renderer processes are not counted: the plugin adds nothing to them
+ * until a page gets the helper script on the first key.
+ */
+
+#include <QCloseEvent>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QKeyEvent>
+#include <QProcess>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+#include "mainapplication.h"
+#include "browserwindow.h"
+#include "datapaths.h"
+#include "pluginproxy.h"
+#include "settings.h"
+#include "tabbedwebview.h"
+
+#define BENCHMARK_PROFILE "VimPluginStartupBenchmark"
+
+struct Sample {
+    qint64 startup_ms;
+    qint64 rss_kb;
+    qint64 first_key_us;
+};
+
+static qint64 residentMemoryKb()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+
+    foreach (const QByteArray &line, status.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+#endif
+    return -1;
+}
+
+static void processEventsFor(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, SLOT(quit()));
+    loop.exec();
+}
+
+static int runChild(bool with_plugin)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    /* Same arguments as the tests: no other instance, own profile. The
+     * application keeps pointers to them, they outlive it.
+     */
+    QByteArray args[] = {
+        QByteArray("qupzilla"),
+        QByteArray("--no-remote"),
+        QByteArray("--profile=" BENCHMARK_PROFILE)
+    };
+    char *argv[] = {
+        args[0].data(),
+        args[1].data(),
+        args[2].data(),
+        nullptr
+    };
+    int argc = sizeof(args) / sizeof(args[0]);
+
+    MainApplication *app = new MainApplication(argc, argv);
+
+    Settings settings;
+    settings.beginGroup("Plugin-Settings");
+    settings.setValue("EnablePlugins", with_plugin);
+    settings.setValue("AllowedPlugins",
+            with_plugin ? QString(LIB_VIM_PLUGIN) : QString());
+    settings.endGroup();
+    settings.syncSettings();
+
+    app->plugins()->loadSettings();
+    app->plugins()->loadPlugins();
+
+    /* Startup is over once the window is shown and the work QupZilla posts
+     * for after launch has run.
+     */
+    while (!app->getWindow() || !app->getWindow()->weView()
+            || !app->getWindow()->isVisible())
+        processEventsFor(5);
+    processEventsFor(0);
+
+    Sample sample;
+    sample.startup_ms = timer.elapsed();
+    sample.rss_kb = residentMemoryKb();
+
+    TabbedWebView *view = app->getWindow()->weView();
+    for (int i = 0; i < 200 && !view->focusProxy(); ++i)
+        processEventsFor(5);
+    QWidget *key_target = view->focusProxy() ? view->focusProxy() : view;
+
+    QKeyEvent press(QEvent::KeyPress, Qt::Key_J, Qt::NoModifier, "j");
+    QKeyEvent release(QEvent::KeyRelease, Qt::Key_J, Qt::NoModifier, "j");
+    QElapsedTimer key_timer;
+    key_timer.start();
+    QCoreApplication::sendEvent(key_target, &press);
+    QCoreApplication::sendEvent(key_target, &release);
+    sample.first_key_us = key_timer.nsecsElapsed() / 1000;
+
+    QTextStream(stdout) << sample.startup_ms << ' ' << sample.rss_kb << ' '
+        << sample.first_key_us << endl;
+
+    const QString profile_path = DataPaths::currentProfilePath();
+    QCoreApplication::postEvent(app->getWindow(), new QCloseEvent);
+    processEventsFor(500);
+    delete app;
+    QDir(profile_path).removeRecursively();
+
+    return 0;
+}
+
+static bool runOnce(bool with_plugin, Sample *res)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(QCoreApplication::applicationFilePath(), QStringList()
+            << "--child" << (with_plugin ? "with-plugin" : "without-plugin"));
+    if (!process.waitForFinished(120000) || 0 != process.exitCode())
+        return false;
+
+    const QList<QByteArray> lines =
+        process.readAllStandardOutput().trimmed().split('\n');
+    const QList<QByteArray> values = lines.last().trimmed().split(' ');
+    if (3 != values.size())
+        return false;
+
+    res->startup_ms = values.at(0).toLongLong();
+    res->rss_kb = values.at(1).toLongLong();
+    res->first_key_us = values.at(2).toLongLong();
+    return true;
+}
+
+static qint64 median(QVector<qint64> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.at(values.size() / 2);
+}
+
+static Sample medianSample(const QVector<Sample> &samples)
+{
+    QVector<qint64> startup_ms, rss_kb, first_key_us;
+    foreach (const Sample &sample, samples) {
+        startup_ms << sample.startup_ms;
+        rss_kb << sample.rss_kb;
+        first_key_us << sample.first_key_us;
+    }
+    return {median(startup_ms), median(rss_kb), median(first_key_us)};
+}
+
+static QString number(double value, int precision, bool show_sign)
+{
+    const QString text = QString::number(value, 'f', precision);
+    return show_sign && value >= 0 ? "+" + text : text;
+}
+
+static QString row(const QString &name, const Sample &sample, bool show_sign)
+{
+    return QString("%1 %2 %3 %4").arg(name, -16)
+        .arg(number(sample.startup_ms, 0, show_sign), 12)
+        .arg(number(sample.rss_kb / 1024.0, 1, show_sign), 10)
+        .arg(number(sample.first_key_us / 1000.0, 2, show_sign), 16);
+}
+
+int main(int argc, char *argv[])
+{
+    if (3 == argc && 0 == qstrcmp(argv[1], "--child"))
+        return runChild(0 == qstrcmp(argv[2], "with-plugin"));
+
+    QCoreApplication app(argc, argv);
+
+    int runs = 5;
+    const int runs_i = app.arguments().indexOf("--runs");
+    if (runs_i > 0)
+        runs = qMax(1, app.arguments().value(runs_i + 1).toInt());
+
+    /* One discarded run of each warms the disk cache, then both variants
+     * alternate so drifts in machine load hit them equally.
+     */
+    QVector<Sample> without_plugin;
+    QVector<Sample> with_plugin;
+    for (int i = -1; i < runs; ++i) {
+        Sample without_sample;
+        Sample with_sample;
+        if (!runOnce(false, &without_sample) || !runOnce(true, &with_sample)) {
+            QTextStream(stderr) << "Benchmark run failed" << endl;
+            return 1;
+        }
+        if (i < 0)
+            continue;
+        without_plugin << without_sample;
+        with_plugin << with_sample;
+    }
+
+    const Sample without = medianSample(without_plugin);
+    const Sample with = medianSample(with_plugin);
+
+    const Sample added = {with.startup_ms - without.startup_ms,
+                          with.rss_kb - without.rss_kb,
+                          with.first_key_us - without.first_key_us};
+
+    QTextStream out(stdout);
+    out << QString("median of %1 runs").arg(runs) << endl
+        << QString("%1 %2 %3 %4").arg("", -16).arg("startup (ms)", 12)
+               .arg("RSS (MB)", 10).arg("first key (ms)", 16) << endl
+        << row("without plugin", without, false) << endl
+        << row("with plugin", with, false) << endl
+        << row("added", added, true) << endl;
+
+    return 0;
+}
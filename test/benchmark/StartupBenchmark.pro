@@ -0,0 +1,40 @@
+# Measures what loading the plugin adds to QupZilla's startup, see
+# StartupBenchmark.cpp.
+
+# We need QupZilla source
+qupzilla_src_dir = $$(QUPZILLA_SRCDIR)
+equals(qupzilla_src_dir, "") {
+    include(../../../../plugins.pri)
+}
+else {
+    include($$qupzilla_src_dir/src/plugins.pri)
+}
+
+!mac:unix {
+    DEFINES += LIB_VIM_PLUGIN=\\\"""$$DESTDIR/libVimPlugin.so"\\\""
+}
+mac {
+    DEFINES += LIB_VIM_PLUGIN=\\\"""$$DESTDIR/libVimPlugin.dylib"\\\""
+}
+
+QT += webenginewidgets
+TEMPLATE = app
+TARGET = VimPluginStartupBenchmark
+
+OBJECTS_DIR = ../../build/benchmark
+MOC_DIR = ../../build/benchmark
+RCC_DIR = ../../build/benchmark
+DESTDIR = ../../build
+
+SOURCES += StartupBenchmark.cpp
+
+INCLUDEPATH += $$qupzilla_src_dir/src/lib/app           \
+               $$qupzilla_src_dir/src/lib/other         \
+               $$qupzilla_src_dir/src/lib/plugins       \
+               $$qupzilla_src_dir/src/lib/tabwidget     \
+               $$qupzilla_src_dir/src/lib/tools         \
+               $$qupzilla_src_dir/src/lib/webengine     \
+               $$qupzilla_src_dir/src/lib/webtab        \
+               $$qupzilla_src_dir/src/lib/3rdparty      \
+
+DEPENDPATH += $$INCLUDEPATH